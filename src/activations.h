@@ -0,0 +1,175 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ACTIVATIONS_H_
+#define ACTIVATIONS_H_
+
+#include <cmath>
+#include "fast_math.h"
+#include "kernels.h"
+
+namespace neuralplex {
+
+// An activation policy is a type with a static Activate member function and a static DerivativeFromOutput member
+// function giving the derivative in terms of the activation's own output, e.g. y * (1 - y) for the sigmoid, so the
+// backward pass reuses the outputs cached by the forward pass instead of evaluating the activation again. Networks
+// built from a policy, see BasicNeuralNet, have the policy inlined into the loops over whole layers so the compiler
+// can vectorize them. Sigmoid and TanhScaled go through libm and are exact to float precision, FastSigmoid and
+// FastTanhScaled run the polynomial kernels in kernels.h over the whole layer and are the ones to train and serve
+// with, the exact policies being there to validate them against. Each policy's kId names it in model files.
+
+// Identifiers of the activations as stored in model files. kActivationCustom marks a network built from activation
+// function pointers, which a model file cannot restore on its own.
+enum ActivationIds {
+  kActivationCustom = 0,
+  kActivationSigmoid,
+  kActivationTanhScaled,
+  kActivationReLU,
+  kActivationFastSigmoid,
+  kActivationFastTanhScaled
+};
+
+// Logistic sigmoid, outputs in (0, 1).
+struct Sigmoid {
+  static const int kId = kActivationSigmoid;
+  static float Activate(float x) { return 1.0f / (1.0f + std::exp(-x)); }
+  static float DerivativeFromOutput(float y) { return y * (1.0f - y); }
+};
+
+// LeCun's scaled hyperbolic tangent a * tanh(b * x) with a = 1.7159 and b = 2 / 3, outputs in (-a, a). Its
+// derivative is a * b * (1 - tanh(b * x)^2) = (a - y^2 / a) * b.
+struct TanhScaled {
+  static const int kId = kActivationTanhScaled;
+  static float Activate(float x) { return kTanhScaledA * std::tanh(kTanhScaledB * x); }
+  static float DerivativeFromOutput(float y) { return (kTanhScaledA - y * y / kTanhScaledA) * kTanhScaledB; }
+};
+
+// Sigmoid through the sigmoid kernels, within 1e-7 of the exact sigmoid and within 1.2e-7, one float ulp near 1.0,
+// of Sigmoid.
+struct FastSigmoid : Sigmoid {
+  static const int kId = kActivationFastSigmoid;
+  static float Activate(float x) {
+    float y;
+    Kernels().sigmoid(&x, &y, 1);
+    return y;
+  }
+};
+
+// TanhScaled through the scaled tanh kernels, within 5e-7 of TanhScaled.
+struct FastTanhScaled : TanhScaled {
+  static const int kId = kActivationFastTanhScaled;
+  static float Activate(float x) {
+    float y;
+    Kernels().tanh_scaled(&x, &y, 1);
+    return y;
+  }
+};
+
+// Rectified linear unit, outputs in [0, inf).
+struct ReLU {
+  static const int kId = kActivationReLU;
+  static float Activate(float x) { return x > 0.0f ? x : 0.0f; }
+  static float DerivativeFromOutput(float y) { return y > 0.0f ? 1.0f : 0.0f; }
+};
+
+// Activation is what a Layer calls into, once per layer per row rather than once per neuron, so the only indirect
+// call left is at layer granularity while the loop over the layer is compiled for the concrete activation. The
+// derivative is always asked for with both the summation and the output of the neuron, so every layer follows the
+// same convention and each activation uses whichever is cheaper for it.
+class Activation {
+ public:
+  virtual ~Activation() { }
+  // One of ActivationIds.
+  virtual int id() const = 0;
+  // Returns a new activation computing the same function, owned by the caller.
+  virtual Activation* Clone() const = 0;
+  virtual float Activate(float x) const = 0;
+  // Derivative of the activation at summation, output being Activate(summation).
+  virtual float Derivative(float summation, float output) const = 0;
+  // y[i] = Activate(x[i]) for i below n, x and y may be the same array.
+  virtual void Activate(const float *x, float *y, int n) const = 0;
+  // y[i] = Derivative(summation[i], output[i]) for i below n, y may be the same array as either input.
+  virtual void Derivative(const float *summation, const float *output, float *y, int n) const = 0;
+};
+
+// Activation compiled for an activation policy.
+template <class Policy>
+class PolicyActivation : public Activation {
+ public:
+  int id() const { return Policy::kId; }
+  Activation* Clone() const { return new PolicyActivation<Policy>(); }
+  float Activate(float x) const { return Policy::Activate(x); }
+  float Derivative(float summation, float output) const { return Policy::DerivativeFromOutput(output); }
+  void Activate(const float *x, float *y, int n) const {
+    for (int i = 0; i < n; i++) y[i] = Policy::Activate(x[i]);
+  }
+  void Derivative(const float *summation, const float *output, float *y, int n) const {
+    for (int i = 0; i < n; i++) y[i] = Policy::DerivativeFromOutput(output[i]);
+  }
+};
+
+// The fast policies hand whole layers to the kernels.
+template <>
+inline void PolicyActivation<FastSigmoid>::Activate(const float *x, float *y, int n) const { Kernels().sigmoid(x, y, n); }
+template <>
+inline void PolicyActivation<FastTanhScaled>::Activate(const float *x, float *y, int n) const { Kernels().tanh_scaled(x, y, n); }
+
+// Activation wrapping a pair of activation and derivative function pointers, for networks built with the original
+// NeuralNet constructors. activation_p only knows the summation so it is evaluated there, in every layer.
+class FunctionActivation : public Activation {
+ public:
+  FunctionActivation(float (*activation)(float), float (*activation_p)(float)) : activation_(activation), activation_p_(activation_p) { }
+  int id() const { return kActivationCustom; }
+  Activation* Clone() const { return new FunctionActivation(activation_, activation_p_); }
+  float Activate(float x) const { return activation_(x); }
+  float Derivative(float summation, float output) const { return activation_p_(summation); }
+  void Activate(const float *x, float *y, int n) const {
+    for (int i = 0; i < n; i++) y[i] = activation_(x[i]);
+  }
+  void Derivative(const float *summation, const float *output, float *y, int n) const {
+    for (int i = 0; i < n; i++) y[i] = activation_p_(summation[i]);
+  }
+
+ private:
+  float (*activation_)(float);
+  float (*activation_p_)(float);
+};
+
+// Returns a new Activation for one of ActivationIds, NULL for kActivationCustom or an unknown id.
+inline Activation* NewActivation(int id) {
+  switch (id) {
+    case kActivationSigmoid: return new PolicyActivation<Sigmoid>();
+    case kActivationTanhScaled: return new PolicyActivation<TanhScaled>();
+    case kActivationReLU: return new PolicyActivation<ReLU>();
+    case kActivationFastSigmoid: return new PolicyActivation<FastSigmoid>();
+    case kActivationFastTanhScaled: return new PolicyActivation<FastTanhScaled>();
+    default: return NULL;
+  }
+}
+
+}  //namespace neuralplex
+#endif /*ACTIVATIONS_H_*/
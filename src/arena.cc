@@ -0,0 +1,61 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <stdlib.h>
+#include <algorithm>
+#include "arena.h"
+
+namespace neuralplex {
+
+Arena::Arena(size_t capacity) {
+  capacity_ = Aligned(capacity);
+  used_ = 0;
+  base_ = NULL;
+  void *base = NULL;
+  if (capacity_ > 0 && posix_memalign(&base, kArenaAlignment, capacity_) != 0) throw std::bad_alloc();
+  base_ = static_cast<char*>(base);
+}
+
+Arena::~Arena() {
+  free(base_);
+}
+
+void* Arena::Allocate(size_t bytes) {
+  size_t size = Aligned(bytes);
+  if (size > capacity_ - used_) throw std::bad_alloc();
+  void *storage = base_ + used_;
+  used_ += size;
+  return storage;
+}
+
+float* Arena::AllocateFloats(size_t n, float value) {
+  float *floats = static_cast<float*>(Allocate(n * sizeof(float)));
+  std::fill(floats, floats + n, value);
+  return floats;
+}
+
+}  //namespace neuralplex
@@ -0,0 +1,71 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+#include <new>
+#include <utility>
+
+namespace neuralplex {
+
+// Alignment of every allocation made from an Arena, one cache line, which also suits aligned SIMD loads.
+const size_t kArenaAlignment = 64;
+
+// Arena hands out storage carved from one block allocated up front and frees all of it at once when it goes away,
+// so a network is built with a single allocation and torn down in constant time however large it is. Nothing
+// allocated from an arena is destroyed on its own: objects placed in it must be trivially destructible or have their
+// destructor run by their owner.
+class Arena {
+ public:
+  // Size an allocation of bytes takes up in an arena, for adding up the capacity an arena needs.
+  static size_t Aligned(size_t bytes) { return (bytes + kArenaAlignment - 1) & ~(kArenaAlignment - 1); }
+  //Arena(): construct a new Arena
+  // capacity: total number of bytes that will be allocated from it, each allocation counted with Aligned.
+  explicit Arena(size_t capacity);
+  virtual ~Arena();
+  // Returns bytes of uninitialized storage, throws std::bad_alloc if the arena is exhausted.
+  void* Allocate(size_t bytes);
+  // Returns n floats set to value.
+  float* AllocateFloats(size_t n, float value = 0.0f);
+  // Constructs a T in the arena.
+  template <class T, class... Args>
+  T* New(Args&&... args) { return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...); }
+  size_t capacity() const { return capacity_; }
+  size_t used() const { return used_; }
+
+ private:
+  Arena(const Arena&);
+  Arena& operator=(const Arena&);
+  char *base_;
+  size_t capacity_;
+  size_t used_;
+};
+
+}  //namespace neuralplex
+#endif /*ARENA_H_*/
@@ -0,0 +1,105 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <stdio.h>
+#include <iostream>
+#include <fstream>
+#include "checkpointer.h"
+#include "neural_net_exceptions.h"
+
+namespace neuralplex {
+
+Checkpointer::Checkpointer(const std::string& path, int interval) : path_(path), interval_(interval) {
+  if (interval < 1) throw TrainingException("checkpoint interval of " + std::to_string(interval) + " epochs");
+  filling_ = pending_ = writing_ = -1;
+  n_written_ = 0;
+  failed_ = false;
+  stopping_ = false;
+  thread_ = std::thread(&Checkpointer::Write, this);
+}
+
+Checkpointer::~Checkpointer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  committed_.notify_one();
+  thread_.join();
+}
+
+bool Checkpointer::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  written_.wait(lock, [this] { return pending_ < 0 && writing_ < 0; });
+  return !failed_;
+}
+
+long Checkpointer::n_written() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return n_written_;
+}
+
+// A waiting checkpoint is taken back to be refilled, otherwise whichever buffer is not being written is used.
+std::vector<char>* Checkpointer::Begin() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  filling_ = pending_ >= 0 ? pending_ : (writing_ == 0 ? 1 : 0);
+  pending_ = -1;
+  return &buffers_[filling_];
+}
+
+void Checkpointer::Commit() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ = filling_;
+    filling_ = -1;
+  }
+  committed_.notify_one();
+}
+
+void Checkpointer::Write() {
+  std::string tmp_path = path_ + ".tmp";
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    committed_.wait(lock, [this] { return stopping_ || pending_ >= 0; });
+    if (pending_ < 0) return;
+    writing_ = pending_;
+    pending_ = -1;
+    const std::vector<char> &buffer = buffers_[writing_];
+    lock.unlock();
+    std::ofstream file(tmp_path.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(buffer.data(), buffer.size());
+    file.close();
+    bool ok = file && rename(tmp_path.c_str(), path_.c_str()) == 0;
+    if (!ok) std::cerr << "cannot write checkpoint " << path_ << std::endl;
+    lock.lock();
+    writing_ = -1;
+    if (ok) n_written_++;
+    else failed_ = true;
+    written_.notify_all();
+  }
+}
+
+}  //namespace neuralplex
@@ -0,0 +1,87 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CHECKPOINTER_H_
+#define CHECKPOINTER_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace neuralplex {
+
+// Checkpointer writes the checkpoints NeuralNet::Train takes to a file from a thread of its own, so training never
+// waits on the disk. It keeps two buffers: while the thread writes one, training copies the next checkpoint into the
+// other, and a checkpoint that is still waiting to be written when the next one is taken is replaced by it rather
+// than waited for. Each checkpoint is written beside the file and renamed over it, so the file always holds a whole
+// checkpoint, the latest written, for NeuralNet::LoadCheckpoint.
+class Checkpointer {
+ public:
+  //Checkpointer(): construct a new Checkpointer
+  // path: file each checkpoint replaces, written to path followed by ".tmp" first.
+  // interval: epochs between checkpoints, at least 1, training also takes one when it stops.
+  // Throws TrainingException for an interval below 1.
+  Checkpointer(const std::string& path, int interval);
+  // Writes the checkpoint waiting to be written, if any, before returning.
+  virtual ~Checkpointer();
+  // Waits until every checkpoint taken so far has been written or replaced. Returns false if any write has failed.
+  bool Flush();
+  const std::string& path() const { return path_; }
+  int interval() const { return interval_; }
+  // Number of checkpoints written to the file.
+  long n_written() const;
+
+ private:
+  friend class NeuralNet;
+  Checkpointer(const Checkpointer&);
+  Checkpointer& operator=(const Checkpointer&);
+  // Returns the buffer to copy the next checkpoint into, which is never the one being written.
+  std::vector<char>* Begin();
+  // Hands the buffer Begin returned to the thread to write.
+  void Commit();
+  void Write();
+  std::string path_;
+  int interval_;
+  std::vector<char> buffers_[2];
+  // Indices into buffers_ of the buffer being filled, the one waiting to be written and the one being written, or
+  // -1 for none.
+  int filling_;
+  int pending_;
+  int writing_;
+  long n_written_;
+  bool failed_;
+  bool stopping_;
+  mutable std::mutex mutex_;
+  std::condition_variable committed_;
+  std::condition_variable written_;
+  std::thread thread_;
+};
+
+}  //namespace neuralplex
+#endif /*CHECKPOINTER_H_*/
@@ -0,0 +1,273 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dataset.h"
+#include "model_file.h"
+#include "neural_net_exceptions.h"
+
+namespace neuralplex {
+
+Dataset::Dataset(long n_rows, const columns_view_t &features, const columns_view_t &labels)
+    : n_rows_(n_rows), features_(features), labels_(labels), kernels_(&Kernels()) {
+  CheckColumns(&features_);
+  CheckColumns(&labels_);
+}
+
+Dataset::Dataset(long n_rows, const columns_view_t &features)
+    : n_rows_(n_rows), features_(features), kernels_(&Kernels()) {
+  CheckColumns(&features_);
+  labels_ = Columns(NULL, features_.type, 0, features_.row_stride);
+}
+
+size_t Dataset::ColumnTypeSize(int type) {
+  switch (type) {
+    case kColumnUint8: return sizeof(uint8_t);
+    case kColumnInt16: return sizeof(int16_t);
+    case kColumnFloat16: return sizeof(uint16_t);
+    case kColumnFloat32: return sizeof(float);
+    default: return 0;
+  }
+}
+
+// Finite floats are rebased onto the half exponent with a rounding bias of half a half ulp less one, plus one more
+// when the kept mantissa is odd, so ties go to even. Floats below the smallest normal half are rounded by adding 0.5,
+// which lines the half's subnormal mantissa up with the low bits of the float.
+uint16_t Dataset::ToFloat16(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t sign = bits & 0x80000000;
+  bits ^= sign;
+  uint16_t half;
+  if (bits >= 0x47800000) {
+    half = bits > 0x7f800000 ? 0x7e00 : 0x7c00;
+  } else if (bits < 0x38800000) {
+    float rounded;
+    memcpy(&rounded, &bits, sizeof(rounded));
+    rounded += 0.5f;
+    memcpy(&bits, &rounded, sizeof(bits));
+    half = bits - 0x3f000000;
+  } else {
+    uint32_t odd = (bits >> 13) & 1;
+    bits += ((uint32_t)(15 - 127) << 23) + 0xfff + odd;
+    half = bits >> 13;
+  }
+  return half | (sign >> 16);
+}
+
+void Dataset::CheckColumns(columns_view_t *view) {
+  long size = ColumnTypeSize(view->type);
+  if (size == 0) throw DatasetException("unknown column type " + std::to_string(view->type));
+  if (view->n_cols < 0) throw DatasetException("negative number of columns");
+  if (view->row_stride == 0) view->row_stride = view->n_cols * size;
+  if (view->row_stride % size != 0 || view->row_stride < 0)
+    throw DatasetException("row stride of " + std::to_string(view->row_stride) + " bytes for columns of " +
+                           std::to_string(size) + " bytes");
+}
+
+void Dataset::Read(const columns_view_t &view, long row, float *out) const {
+  const void *values = static_cast<const char*>(view.data) + row * view.row_stride;
+  switch (view.type) {
+    case kColumnUint8:
+      kernels_->widen_uint8(static_cast<const uint8_t*>(values), out, view.n_cols);
+      break;
+    case kColumnInt16:
+      kernels_->widen_int16(static_cast<const int16_t*>(values), out, view.n_cols);
+      break;
+    case kColumnFloat16:
+      kernels_->widen_float16(static_cast<const uint16_t*>(values), out, view.n_cols);
+      break;
+    default:
+      std::copy(static_cast<const float*>(values), static_cast<const float*>(values) + view.n_cols, out);
+  }
+}
+
+long Dataset::chunk_rows() const {
+  long row_bytes = std::max(1L, std::max(features_.row_stride, labels_.row_stride));
+  return std::max(1L, kDatasetChunkBytes / row_bytes / kTrainBatchRows) * kTrainBatchRows;
+}
+
+void Dataset::ForEachChunk(long begin, long end, const std::function<void(long, long)>& visit) const {
+  long n_chunk_rows = chunk_rows();
+  if (begin < end) Prefetch(begin, std::min(end, begin + n_chunk_rows));
+  for (long chunk = begin; chunk < end; chunk += n_chunk_rows) {
+    long chunk_end = std::min(end, chunk + n_chunk_rows);
+    if (chunk_end < end) Prefetch(chunk_end, std::min(end, chunk_end + n_chunk_rows));
+    visit(chunk, chunk_end);
+    Evict(chunk, chunk_end);
+  }
+}
+
+// Records are copied together a row at a time and written through the stream's buffer. The header goes in last, so
+// an append cut short leaves the file holding the rows it held before.
+bool Dataset::Save(const char *path, bool append) const {
+  try {
+    if (features_.n_cols == 0) throw DatasetException("no features to save");
+    dataset_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kDatasetFileMagic, sizeof(header.magic));
+    header.version = kDatasetFileVersion;
+    header.byte_order = kModelFileByteOrder;
+    header.header_size = sizeof(header);
+    header.features_type = features_.type;
+    header.n_features = features_.n_cols;
+    header.labels_type = labels_.type;
+    header.n_labels = labels_.n_cols;
+    uint64_t features_bytes = (uint64_t)features_.n_cols * ColumnTypeSize(features_.type);
+    uint64_t label_size = ColumnTypeSize(labels_.type);
+    uint64_t labels_bytes = labels_.n_cols * label_size;
+    uint64_t record_alignment = std::max<uint64_t>(ColumnTypeSize(features_.type), label_size);
+    header.labels_offset = (features_bytes + label_size - 1) / label_size * label_size;
+    header.row_stride =
+        (header.labels_offset + labels_bytes + record_alignment - 1) / record_alignment * record_alignment;
+    header.data_offset = (sizeof(header) + kModelFileAlignment - 1) & ~(kModelFileAlignment - 1);
+    header.n_rows = n_rows_;
+    std::fstream file;
+    if (append) {
+      file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+      if (!file) throw DatasetException(std::string("cannot open ") + path);
+      dataset_file_header_t existing;
+      file.read(reinterpret_cast<char*>(&existing), sizeof(existing));
+      if (!file || memcmp(existing.magic, kDatasetFileMagic, sizeof(existing.magic)) != 0 ||
+          existing.version != kDatasetFileVersion || existing.byte_order != kModelFileByteOrder ||
+          existing.header_size != sizeof(existing))
+        throw DatasetException(std::string("not a dataset file of this version ") + path);
+      if (existing.features_type != header.features_type || existing.n_features != header.n_features ||
+          existing.labels_type != header.labels_type || existing.n_labels != header.n_labels ||
+          existing.labels_offset != header.labels_offset || existing.row_stride != header.row_stride)
+        throw DatasetException(std::string("other columns in ") + path);
+      header.data_offset = existing.data_offset;
+      header.n_rows += existing.n_rows;
+      file.seekp(existing.data_offset + existing.n_rows * existing.row_stride);
+    } else {
+      file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+      if (!file) throw DatasetException(std::string("cannot create ") + path);
+      std::vector<char> padding(header.data_offset - sizeof(header));
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(&padding[0], padding.size());
+    }
+    std::vector<char> record(header.row_stride);
+    for (long row = 0; row < n_rows_ && file; row++) {
+      memcpy(&record[0], static_cast<const char*>(features_.data) + row * features_.row_stride, features_bytes);
+      if (labels_bytes) {
+        memcpy(&record[header.labels_offset], static_cast<const char*>(labels_.data) + row * labels_.row_stride,
+               labels_bytes);
+      }
+      file.write(&record[0], record.size());
+    }
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    if (!file) throw DatasetException(std::string("cannot write ") + path);
+    return true;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+MappedDataset::MappedDataset(long n_rows, const columns_view_t &features, const columns_view_t &labels,
+                             void *mapping, size_t mapping_size, size_t data_offset, size_t row_stride)
+    : Dataset(n_rows, features, labels), mapping_(mapping), mapping_size_(mapping_size), data_offset_(data_offset),
+      row_stride_(row_stride) { }
+
+MappedDataset::~MappedDataset() {
+  munmap(mapping_, mapping_size_);
+}
+
+MappedDataset* MappedDataset::Map(const char *path) {
+  int fd = -1;
+  void *mapping = MAP_FAILED;
+  size_t size = 0;
+  try {
+    fd = open(path, O_RDONLY);
+    if (fd < 0) throw DatasetException(std::string("cannot open ") + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) throw DatasetException(std::string("cannot stat ") + path);
+    size = st.st_size;
+    if (size < sizeof(dataset_file_header_t)) throw DatasetException("truncated");
+    mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) throw DatasetException(std::string("cannot map ") + path);
+    close(fd);
+    fd = -1;
+    const dataset_file_header_t &header = *static_cast<const dataset_file_header_t*>(mapping);
+    if (memcmp(header.magic, kDatasetFileMagic, sizeof(header.magic)) != 0)
+      throw DatasetException("not a dataset file");
+    if (header.byte_order != kModelFileByteOrder) throw DatasetException("written with another byte order");
+    if (header.version != kDatasetFileVersion || header.header_size != sizeof(header))
+      throw DatasetException("unsupported version " + std::to_string(header.version));
+    uint64_t feature_size = ColumnTypeSize(header.features_type);
+    uint64_t label_size = ColumnTypeSize(header.labels_type);
+    if (feature_size == 0 || label_size == 0 || header.n_features <= 0 || header.n_labels < 0)
+      throw DatasetException("bad columns");
+    if (header.labels_offset < header.n_features * feature_size ||
+        header.labels_offset + header.n_labels * label_size > header.row_stride ||
+        header.row_stride % feature_size || header.row_stride % label_size || header.labels_offset % label_size)
+      throw DatasetException("bad record layout");
+    if (header.data_offset < sizeof(header) || header.data_offset % kModelFileAlignment || header.data_offset > size ||
+        header.n_rows > (size - header.data_offset) / header.row_stride)
+      throw DatasetException("truncated");
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    const char *data = static_cast<const char*>(mapping) + header.data_offset;
+    return new MappedDataset(header.n_rows, Columns(data, header.features_type, header.n_features, header.row_stride),
+                             Columns(data + header.labels_offset, header.labels_type, header.n_labels,
+                                     header.row_stride),
+                             mapping, size, header.data_offset, header.row_stride);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    if (fd >= 0) close(fd);
+    if (mapping != MAP_FAILED) munmap(mapping, size);
+    return NULL;
+  }
+}
+
+// Rows are turned into pages rounded outwards for reading ahead and inwards for dropping, so that a page holding
+// rows another worker is still reading is never dropped.
+void MappedDataset::Prefetch(long begin, long end) const {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t first = (data_offset_ + begin * row_stride_) / page_size * page_size;
+  size_t last = data_offset_ + end * row_stride_;
+  if (last > first) madvise(static_cast<char*>(mapping_) + first, last - first, MADV_WILLNEED);
+}
+
+void MappedDataset::Evict(long begin, long end) const {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t first = (data_offset_ + begin * row_stride_ + page_size - 1) / page_size * page_size;
+  size_t last = (data_offset_ + end * row_stride_) / page_size * page_size;
+  if (last > first) madvise(static_cast<char*>(mapping_) + first, last - first, MADV_DONTNEED);
+}
+
+}  //namespace neuralplex
@@ -0,0 +1,140 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef DATASET_H_
+#define DATASET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include "kernels.h"
+#include "neural_net_constants.h"
+
+namespace neuralplex {
+
+// Dataset describes rows of training or scoring data held by the caller as two blocks of typed columns, the features
+// fed to the network's inputs and the labels its outputs are trained towards. Each block is stored as one of
+// ColumnTypes and has a row stride of its own, so features and labels may sit in separate arrays or interleaved in
+// one array of records, and a character or pixel can take a byte rather than a float. Values are widened to float by
+// the widen kernels as rows are read, so no float copy of the data is ever built. A dataset only points at the data,
+// which must outlive it and is never written to.
+class Dataset {
+ public:
+  // n_cols columns of one type, column c of row r at data + r * row_stride + c * ColumnTypeSize(type). row_stride
+  // is in bytes and a multiple of the size of the type, 0 packing rows with no gap.
+  typedef struct {
+    const void *data;
+    int type;
+    int n_cols;
+    long row_stride;
+  } columns_view_t;
+
+  //Dataset(): construct a new Dataset
+  // n_rows: number of rows.
+  // features: the inputs of each row.
+  // labels: optional ideal outputs of each row, required to train on the dataset.
+  // Throws DatasetException if a view has an unknown type or a row stride that is not a whole number of values.
+  Dataset(long n_rows, const columns_view_t &features, const columns_view_t &labels);
+  Dataset(long n_rows, const columns_view_t &features);
+  virtual ~Dataset() { }
+  // Returns a view of n_cols columns of type starting at data, rows row_stride bytes apart.
+  static columns_view_t Columns(const void *data, int type, int n_cols, long row_stride = 0) {
+    columns_view_t view = {data, type, n_cols, row_stride};
+    return view;
+  }
+  // Bytes a value of type takes, 0 for an unknown type.
+  static size_t ColumnTypeSize(int type);
+  // Rounds value to the nearest half, ties to even, for storing kColumnFloat16 columns.
+  static uint16_t ToFloat16(float value);
+  long n_rows() const { return n_rows_; }
+  const columns_view_t& features() const { return features_; }
+  const columns_view_t& labels() const { return labels_; }
+  // Returns the features of row in place when they are stored as floats, NULL otherwise.
+  const float* float_features(long row) const {
+    if (features_.type != kColumnFloat32) return NULL;
+    return reinterpret_cast<const float*>(static_cast<const char*>(features_.data) + row * features_.row_stride);
+  }
+  // Writes the features or labels of row, widened to float, to out.
+  void ReadFeatures(long row, float *out) const { Read(features_, row, out); }
+  void ReadLabels(long row, float *out) const { Read(labels_, row, out); }
+  // Rows of a chunk, a whole number of kTrainBatchRows tiles taking up about kDatasetChunkBytes.
+  long chunk_rows() const;
+  // Calls visit(chunk_begin, chunk_end) for rows [begin, end) a chunk of chunk_rows() rows at a time, in order,
+  // having asked for the next chunk to be read ahead and letting go of each chunk once visited. Reading a dataset
+  // this way keeps only the chunks in use in memory when it is mapped from a file, see MappedDataset.
+  void ForEachChunk(long begin, long end, const std::function<void(long, long)>& visit) const;
+  // Writes the rows of the dataset to a dataset file at path, see dataset_file_header_t, or adds them to the end of
+  // the one there when append is set, so a file larger than memory can be written a part at a time. Returns false if
+  // the file cannot be written or, when appending, holds columns of other types or numbers.
+  bool Save(const char *path, bool append = false) const;
+
+ protected:
+  // Hints that rows [begin, end) are about to be read, or will not be read again for a while. No-ops for a dataset
+  // in memory.
+  virtual void Prefetch(long begin, long end) const { }
+  virtual void Evict(long begin, long end) const { }
+
+ private:
+  // Checks view and fills in a packed row stride.
+  static void CheckColumns(columns_view_t *view);
+  void Read(const columns_view_t &view, long row, float *out) const;
+  long n_rows_;
+  columns_view_t features_;
+  columns_view_t labels_;
+  const kernels_t *kernels_;
+};
+
+// MappedDataset is a Dataset read in place from a shared, read-only mapping of a dataset file, so the dataset can be
+// larger than memory. The mapping is advised for sequential reading, and as rows are read through ForEachChunk, as
+// training reads them, the next chunk is asked for ahead with MADV_WILLNEED and each finished chunk dropped with
+// MADV_DONTNEED. The pages dropped stay in the page cache while memory allows, so a dataset that fits is still read
+// from memory after the first epoch.
+class MappedDataset : public Dataset {
+ public:
+  // Returns the dataset in the dataset file at path, or NULL if it cannot be mapped or is not a dataset file of this
+  // version.
+  static MappedDataset* Map(const char *path);
+  virtual ~MappedDataset();
+
+ protected:
+  virtual void Prefetch(long begin, long end) const;
+  virtual void Evict(long begin, long end) const;
+
+ private:
+  MappedDataset(long n_rows, const columns_view_t &features, const columns_view_t &labels, void *mapping,
+                size_t mapping_size, size_t data_offset, size_t row_stride);
+  MappedDataset(const MappedDataset&);
+  MappedDataset& operator=(const MappedDataset&);
+  void *mapping_;
+  size_t mapping_size_;
+  // Where the records start in the mapping and their size, for turning rows into pages.
+  size_t data_offset_;
+  size_t row_stride_;
+};
+
+}  //namespace neuralplex
+#endif /*DATASET_H_*/
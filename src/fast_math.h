@@ -0,0 +1,75 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef FAST_MATH_H_
+#define FAST_MATH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+namespace neuralplex {
+
+// Constants of the exp approximation shared by the scalar and SIMD activation kernels. exp(x) is split into
+// 2^k * exp(r) with k = round(x / ln 2), r = x - k ln 2 is reduced in two steps to keep it accurate, and exp(r) over
+// |r| <= ln 2 / 2 is the polynomial 1 + r + r^2 * p(r), p of degree 5, from Cephes' expf, which is within 2 ulp of
+// exp. Arguments are clamped to keep 2^k a normal float.
+const float kFastExpMin = -87.3f;
+const float kFastExpMax = 88.3f;
+const float kFastExpLog2e = 1.44269504088896341f;
+const float kFastExpLn2Hi = 0.693359375f;
+const float kFastExpLn2Lo = -2.12194440e-4f;
+const float kFastExpP0 = 1.9875691500e-4f;
+const float kFastExpP1 = 1.3981999507e-3f;
+const float kFastExpP2 = 8.3334519073e-3f;
+const float kFastExpP3 = 4.1665795894e-2f;
+const float kFastExpP4 = 1.6666665459e-1f;
+const float kFastExpP5 = 5.0000001201e-1f;
+
+// Scale and slope of the scaled hyperbolic tangent 1.7159 * tanh(2x / 3).
+const float kTanhScaledA = 1.7159f;
+const float kTanhScaledB = 0.66666667f;
+
+// A half is widened by shifting its exponent and mantissa into the low bits of a float's and multiplying by 2^112,
+// which rebases the exponent and turns the half subnormals, float subnormals after the shift, into normal floats
+// exactly. Anything that comes out at 2^16 or more was an infinity or NaN and is given an all-ones exponent.
+const float kHalfRebase = 5.192296858534828e+33f;
+const float kHalfInfinity = 65536.0f;
+
+inline float HalfToFloat(uint16_t half) {
+  uint32_t bits = (uint32_t)(half & 0x7fff) << 13;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  value *= kHalfRebase;
+  memcpy(&bits, &value, sizeof(bits));
+  if (value >= kHalfInfinity) bits |= 0x7f800000;
+  bits |= (uint32_t)(half & 0x8000) << 16;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+}  //namespace neuralplex
+#endif /*FAST_MATH_H_*/
@@ -0,0 +1,145 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <vector>
+#include "neural_net_constants.h"
+#include "neural_net_exceptions.h"
+#include "frozen_net.h"
+
+namespace neuralplex {
+
+FrozenNet::FrozenNet(const NeuralNet& neural_net, bool fold_normalization)
+    : n_input_(neural_net.n_input_), n_hidden_(neural_net.n_hidden_), n_output_(neural_net.n_output_),
+      arena_(Arena::Aligned(neural_net.hidden_layer_->n_params() * sizeof(float)) +
+             Arena::Aligned(neural_net.output_layer_->n_params() * sizeof(float)) +
+             (fold_normalization ? 0 : 2 * Arena::Aligned(neural_net.n_input_ * sizeof(float)))) {
+  const float *hidden_params = neural_net.hidden_layer_->params();
+  const float *output_params = neural_net.output_layer_->params();
+  hidden_params_ = static_cast<float*>(arena_.Allocate(neural_net.hidden_layer_->n_params() * sizeof(float)));
+  std::copy(hidden_params, hidden_params + neural_net.hidden_layer_->n_params(), hidden_params_);
+  output_params_ = static_cast<float*>(arena_.Allocate(neural_net.output_layer_->n_params() * sizeof(float)));
+  std::copy(output_params, output_params + neural_net.output_layer_->n_params(), output_params_);
+  if (fold_normalization) {
+    FoldNormalization(neural_net.input_scale_, neural_net.input_offset_);
+    input_scale_ = input_offset_ = NULL;
+  } else {
+    input_scale_ = static_cast<float*>(arena_.Allocate(n_input_ * sizeof(float)));
+    std::copy(neural_net.input_scale_, neural_net.input_scale_ + n_input_, input_scale_);
+    input_offset_ = static_cast<float*>(arena_.Allocate(n_input_ * sizeof(float)));
+    std::copy(neural_net.input_offset_, neural_net.input_offset_ + n_input_, input_offset_);
+  }
+  activation_ = neural_net.activation_->Clone();
+  kernels_ = &Kernels();
+}
+
+FrozenNet::~FrozenNet() {
+  delete activation_;
+}
+
+// The summation of hidden neuron n is b[n] + the sum over x of w[n][x] * (inputs[x] * scale[x] + offset[x]), which is
+// (b[n] + the sum over x of w[n][x] * offset[x]) + the sum over x of (w[n][x] * scale[x]) * inputs[x]. The new bias
+// is added up in double so it is rounded once.
+void FrozenNet::FoldNormalization(const float *scale, const float *offset) {
+  float *biases = hidden_params_ + n_hidden_ * n_input_;
+  for (int n = 0; n < n_hidden_; n++) {
+    float *weights = hidden_params_ + n * n_input_;
+    double bias = biases[n];
+    for (int x = 0; x < n_input_; x++) {
+      bias += (double)weights[x] * offset[x];
+      weights[x] *= scale[x];
+    }
+    biases[n] = bias;
+  }
+}
+
+float FrozenNet::MaxDeviation(const NeuralNet& neural_net, const float* inputs, size_t n_rows,
+                              size_t input_stride) const {
+  std::vector<float> outputs(n_rows * n_output_);
+  std::vector<float> expected(n_rows * n_output_);
+  ComputeBatch(inputs, n_rows, &outputs[0], input_stride);
+  neural_net.ComputeBatch(inputs, n_rows, &expected[0], input_stride);
+  float deviation = 0.0f;
+  for (size_t i = 0; i < outputs.size(); i++) deviation = std::max(deviation, std::fabs(outputs[i] - expected[i]));
+  return deviation;
+}
+
+void FrozenNet::ComputeBatch(const float* inputs, size_t n_rows, float* outputs, size_t input_stride,
+                             size_t output_stride) const {
+  try {
+    ComputeBatch(Dataset(n_rows, Dataset::Columns(inputs, kColumnFloat32, n_input_, input_stride * sizeof(float))),
+                 outputs, output_stride);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+// A folded network reads float features in place. Other features are widened into the normalized tile first, and
+// normalized there unless folded.
+void FrozenNet::ComputeBatch(const Dataset& dataset, float* outputs, size_t output_stride) const {
+  try {
+    if (dataset.features().n_cols != n_input_)
+      throw DatasetException(std::to_string(dataset.features().n_cols) + " features given to a network of " +
+                             std::to_string(n_input_) + " inputs");
+    size_t n_rows = dataset.n_rows();
+    if (output_stride == 0) output_stride = n_output_;
+    bool in_place = folded() && dataset.features().type == kColumnFloat32;
+    long input_stride = dataset.features().row_stride / (long)sizeof(float);
+    size_t n_tile_rows = std::min(n_rows, (size_t)kComputeBatchRows);
+    std::vector<float> normalized(in_place ? 0 : n_tile_rows * n_input_);
+    std::vector<float> hidden(n_tile_rows * n_hidden_);
+    for (size_t row = 0; row < n_rows; row += n_tile_rows) {
+      int n = std::min(n_rows - row, n_tile_rows);
+      if (in_place) {
+        Forward(hidden_params_, n_hidden_, n_input_, dataset.float_features(row), input_stride, &hidden[0], n_hidden_,
+                n);
+      } else {
+        for (int r = 0; r < n; r++) {
+          float *in = &normalized[r * n_input_];
+          dataset.ReadFeatures(row + r, in);
+          if (folded()) continue;
+          for (int x = 0; x < n_input_; x++) in[x] = in[x] * input_scale_[x] + input_offset_[x];
+        }
+        Forward(hidden_params_, n_hidden_, n_input_, &normalized[0], n_input_, &hidden[0], n_hidden_, n);
+      }
+      Forward(output_params_, n_output_, n_hidden_, &hidden[0], n_hidden_, outputs + row * output_stride, output_stride, n);
+    }
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+void FrozenNet::Forward(const float *params, int n_neurons, int n_inputs, const float *in, long ld_in, float *out,
+                        long ld_out, int n_rows) const {
+  kernels_->mat_mat(params, in, params + n_neurons * n_inputs, out, n_neurons, n_inputs, n_rows, ld_in, ld_out);
+  for (int row = 0; row < n_rows; row++) activation_->Activate(out + row * ld_out, out + row * ld_out, n_neurons);
+}
+
+}  //namespace neuralplex
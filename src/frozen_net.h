@@ -0,0 +1,95 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef FROZEN_NET_H_
+#define FROZEN_NET_H_
+
+#include<stdlib.h>
+#include "activations.h"
+#include "arena.h"
+#include "kernels.h"
+#include "neural_net.h"
+
+namespace neuralplex {
+
+// FrozenNet is a trained NeuralNet reduced to what computing rows needs: the weights and biases of each layer and the
+// scale and offset of each input, held together in one allocation, and the activation.
+// It keeps no neurons, names, workspaces, gradients or learning state, so it is the smallest form a network can be
+// served in. As the normalization of each input is affine it can also be folded into the hidden layer, input x's
+// scale multiplying every weight from it and its offset times those weights adding to the biases, so that rows go
+// into the first matrix product as they are, with no normalization work or copy.
+// It is independent of the network it was frozen from and never changes, so any number of threads may compute with
+// it at once.
+class FrozenNet {
+ public:
+  //FrozenNet(): construct a new FrozenNet
+  // neural_net: the trained network to copy the parameters, activation and normalisation of.
+  // fold_normalization: fold the normalization into the hidden layer's weights and biases. The outputs then differ
+  //   from the network's by the rounding of the folded parameters, see MaxDeviation.
+  explicit FrozenNet(const NeuralNet& neural_net, bool fold_normalization = false);
+  virtual ~FrozenNet();
+  // inputs: array of approximated functions inputs, left untouched
+  // outputs: results of approximated function with supplied inputs
+  void Compute(const float* inputs, float* outputs) const { ComputeBatch(inputs, 1, outputs); }
+  // Same as NeuralNet::ComputeBatch, giving the same outputs as the network frozen unless the normalization is folded.
+  void ComputeBatch(const float* inputs, size_t n_rows, float* outputs, size_t input_stride = 0, size_t output_stride = 0) const;
+  void ComputeBatch(const Dataset& dataset, float* outputs, size_t output_stride = 0) const;
+  // Returns the largest absolute difference between an output computed here and the same output computed by
+  // neural_net, over n_rows rows of inputs laid out as for ComputeBatch. Checks a folded network against the one it
+  // was frozen from.
+  float MaxDeviation(const NeuralNet& neural_net, const float* inputs, size_t n_rows, size_t input_stride = 0) const;
+  bool folded() const { return input_scale_ == NULL; }
+  int n_input() const { return n_input_; }
+  int n_hidden() const { return n_hidden_; }
+  int n_output() const { return n_output_; }
+  // Bytes held for the parameters and input scales and offsets.
+  size_t params_size() const { return arena_.capacity(); }
+
+ private:
+  FrozenNet(const FrozenNet&);
+  FrozenNet& operator=(const FrozenNet&);
+  // Folds the input scales and offsets into the copy of the hidden layer's parameters.
+  void FoldNormalization(const float *scale, const float *offset);
+  // Writes the activations of a layer of n_neurons fed by n_inputs for n_rows rows, as Layer::ForwardBatch does.
+  void Forward(const float *params, int n_neurons, int n_inputs, const float *in, long ld_in, float *out, long ld_out,
+               int n_rows) const;
+  int n_input_;
+  int n_hidden_;
+  int n_output_;
+  Arena arena_;
+  // Each layer's weights in row-major order followed by its biases, as a Layer stores them.
+  float *hidden_params_;
+  float *output_params_;
+  // Normalised input x is inputs[x] * input_scale_[x] + input_offset_[x], both NULL once folded.
+  float *input_scale_;
+  float *input_offset_;
+  Activation *activation_;
+  const kernels_t *kernels_;
+};
+
+}  //namespace neuralplex
+#endif /*FROZEN_NET_H_*/
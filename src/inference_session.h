@@ -0,0 +1,64 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef INFERENCE_SESSION_H_
+#define INFERENCE_SESSION_H_
+
+#include<stdlib.h>
+#include<vector>
+#include "neural_net.h"
+
+namespace neuralplex {
+
+// InferenceSession scores rows against a trained NeuralNet without writing to it. The activations of every layer
+// are kept in scratch memory owned by the session and reused from call to call, and the caller's inputs are never
+// modified. Threads can share one network by giving each thread a session of its own, as long as nothing trains
+// the network while they do.
+class InferenceSession {
+ public:
+  //InferenceSession(): construct a new InferenceSession
+  // neural_net: the network to score against, which must outlive the session.
+  explicit InferenceSession(const NeuralNet& neural_net) : neural_net_(neural_net) { }
+  virtual ~InferenceSession() { }
+  // inputs: array of approximated functions inputs, left untouched
+  // outputs: results of approximated function with supplied inputs
+  void Compute(const float* inputs, float* outputs) { ComputeBatch(inputs, 1, outputs); }
+  // Same as NeuralNet::ComputeBatch using the session's scratch memory.
+  void ComputeBatch(const float* inputs, size_t n_rows, float* outputs, size_t input_stride = 0, size_t output_stride = 0) {
+    neural_net_.ComputeBatch(neural_net_.InputsDataset(inputs, n_rows, input_stride), outputs, output_stride, &tiles_);
+  }
+  void ComputeBatch(const Dataset& dataset, float* outputs, size_t output_stride = 0) {
+    neural_net_.ComputeBatch(dataset, outputs, output_stride, &tiles_);
+  }
+
+ private:
+  const NeuralNet& neural_net_;
+  std::vector< std::vector<float> > tiles_;
+};
+
+}  //namespace neuralplex
+#endif /*INFERENCE_SESSION_H_*/
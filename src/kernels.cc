@@ -0,0 +1,176 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "fast_math.h"
+#include "kernels.h"
+#include "neural_net_constants.h"
+
+namespace neuralplex {
+
+static void MatVecScalar(const float *w, const float *x, const float *b, float *y, int rows, int cols) {
+  for (int r = 0; r < rows; r++) {
+    const float *row = w + (long)r * cols;
+    float summation = b[r];
+    for (int c = 0; c < cols; c++) summation += x[c] * row[c];
+    y[r] = summation;
+  }
+}
+
+static void MatMatScalar(const float *w, const float *x, const float *b, float *y, int rows, int cols, int n_x, long ldx, long ldy) {
+  for (int i = 0; i < n_x; i++) MatVecScalar(w, x + i * ldx, b, y + i * ldy, rows, cols);
+}
+
+static void GemmScalar(const float *a, long a_row, long a_col, const float *b, long ldb, float *c, long ldc, int m, int n, int k, bool accumulate) {
+  for (int i = 0; i < m; i++) {
+    float *c_row = c + i * ldc;
+    if (!accumulate) std::fill(c_row, c_row + n, 0.0f);
+    for (int p = 0; p < k; p++) {
+      float a_ip = a[i * a_row + p * a_col];
+      const float *b_row = b + p * ldb;
+      for (int j = 0; j < n; j++) c_row[j] += a_ip * b_row[j];
+    }
+  }
+}
+
+static inline float FastExp(float x) {
+  x = std::min(std::max(x, kFastExpMin), kFastExpMax);
+  float k = std::nearbyint(x * kFastExpLog2e);
+  float r = x - k * kFastExpLn2Hi;
+  r = r - k * kFastExpLn2Lo;
+  float p = kFastExpP0;
+  p = p * r + kFastExpP1;
+  p = p * r + kFastExpP2;
+  p = p * r + kFastExpP3;
+  p = p * r + kFastExpP4;
+  p = p * r + kFastExpP5;
+  float y = p * (r * r) + r + 1.0f;
+  int bits = ((int)k + 127) << 23;
+  float scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return y * scale;
+}
+
+static inline float FastSigmoid(float x) {
+  return 1.0f / (1.0f + FastExp(-x));
+}
+
+static inline float FastTanh(float x) {
+  return 1.0f - 2.0f / (1.0f + FastExp(2.0f * x));
+}
+
+static void SigmoidScalar(const float *x, float *y, int n) {
+  for (int i = 0; i < n; i++) y[i] = FastSigmoid(x[i]);
+}
+
+static void TanhScaledScalar(const float *x, float *y, int n) {
+  for (int i = 0; i < n; i++) y[i] = kTanhScaledA * FastTanh(kTanhScaledB * x[i]);
+}
+
+static void RPropScalar(float *weight, float *gradient, const rprop_state_t &state, int n) {
+  for (int i = 0; i < n; i++) {
+    float gradient_batch_sum = -gradient[i];
+    gradient[i] = 0.0f;
+    float rolling_gradient = gradient_batch_sum * state.last_gradient_batch_sum[i];
+    bool faster = rolling_gradient > 0;
+    bool slower = rolling_gradient < 0;
+    float current_weight = weight[i] + state.next_step[i];
+    float update_val = state.update_val[i];
+    float last_update_val = state.last_update_val[i];
+    float weight_delta = state.weight_delta[i];
+    float last_weight_delta = state.last_weight_delta[i];
+    float next_update_val = faster ? std::min(last_update_val * kResilientPropFaster, kResilientPropDeltaMax) :
+        slower ? std::max(last_update_val * kResilientPropSlower, kResilientPropUpdateMin) : update_val;
+    float step = -sgn(gradient_batch_sum) * next_update_val;
+    weight[i] = current_weight;
+    state.last_gradient_batch_sum[i] = slower ? 0.0f : gradient_batch_sum;
+    state.update_val[i] = next_update_val;
+    state.last_update_val[i] = faster ? update_val : last_update_val;
+    state.weight_delta[i] = slower ? weight_delta : step;
+    state.last_weight_delta[i] = slower ? last_weight_delta : weight_delta;
+    state.next_step[i] = slower ? -last_weight_delta : step;
+  }
+}
+
+static void ColumnStatsScalar(const float *x, long n_rows, long ldx, int n_cols, float *min, float *max, double *sum,
+                              double *sum_sq) {
+  for (long r = 0; r < n_rows; r++) {
+    const float *row = x + r * ldx;
+    for (int c = 0; c < n_cols; c++) {
+      float v = row[c];
+      min[c] = v < min[c] ? v : min[c];
+      max[c] = v > max[c] ? v : max[c];
+      double d = v;
+      sum[c] += d;
+      sum_sq[c] += d * d;
+    }
+  }
+}
+
+static void WidenUint8Scalar(const uint8_t *x, float *y, int n) {
+  for (int i = 0; i < n; i++) y[i] = x[i];
+}
+
+static void WidenInt16Scalar(const int16_t *x, float *y, int n) {
+  for (int i = 0; i < n; i++) y[i] = x[i];
+}
+
+static void WidenFloat16Scalar(const uint16_t *x, float *y, int n) {
+  for (int i = 0; i < n; i++) y[i] = HalfToFloat(x[i]);
+}
+
+const kernels_t kScalarKernels = {
+  "scalar",
+  MatVecScalar,
+  MatMatScalar,
+  GemmScalar,
+  SigmoidScalar,
+  TanhScaledScalar,
+  RPropScalar,
+  ColumnStatsScalar,
+  WidenUint8Scalar,
+  WidenInt16Scalar,
+  WidenFloat16Scalar
+};
+
+static const kernels_t* SelectKernels() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma")) return &kAvx512Kernels;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return &kAvx2Kernels;
+#endif
+  return &kScalarKernels;
+}
+
+const kernels_t& Kernels() {
+  static const kernels_t *kernels = SelectKernels();
+  return *kernels;
+}
+
+}  //namespace neuralplex
@@ -0,0 +1,98 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include <stdint.h>
+
+namespace neuralplex {
+
+// Resilient propagation state of n parameters, one array per field. weight_delta is the step taken by the last
+// update and next_step the step the following update adds to the weight before stepping again. Holding the step
+// rather than the weight it leads to lets the weights be set between updates without touching the state.
+typedef struct {
+  float *last_gradient_batch_sum;
+  float *update_val;
+  float *last_update_val;
+  float *next_step;
+  float *weight_delta;
+  float *last_weight_delta;
+} rprop_state_t;
+
+// The compute kernels behind the layer loops. Every kernel has a portable scalar implementation and, on x86-64,
+// AVX2/FMA and AVX-512 implementations built from their own translation units with the matching compiler flags.
+// The fastest table the running CPU supports is picked once from CPUID, so one binary runs across machines of
+// different generations. The scalar kernels add up terms in the same order as the per neuron loops.
+typedef struct {
+  const char *name;
+  // y[r] = b[r] + the sum over c of w[r * cols + c] * x[c], where w is a rows x cols row-major matrix.
+  void (*mat_vec)(const float *w, const float *x, const float *b, float *y, int rows, int cols);
+  // The same product for n_x vectors at once: y[i * ldy + r] = b[r] + the sum over c of w[r * cols + c] * x[i * ldx + c]
+  // for i below n_x, blocked so that each tile of w is loaded once for all n_x vectors rather than once per vector.
+  void (*mat_mat)(const float *w, const float *x, const float *b, float *y, int rows, int cols, int n_x, long ldx, long ldy);
+  // c[i * ldc + j] = the sum over p below k of a[i * a_row + p * a_col] * b[p * ldb + j] for i below m and j below n,
+  // added to what c already holds when accumulate is set. a is read through a row and a column stride so that it
+  // can be multiplied as it is or transposed without a copy. Each tile of c is kept in registers while p sweeps,
+  // and every element of c adds up its terms in order of p.
+  void (*gemm)(const float *a, long a_row, long a_col, const float *b, long ldb, float *c, long ldc, int m, int n, int k, bool accumulate);
+  // Activations over n floats, y[i] = f(x[i]) where x and y may be the same array. exp is the polynomial
+  // approximation described in fast_math.h rather than a libm call, which leaves the results within 1e-7 of the
+  // exact sigmoid, 1.2e-7 of the float libm one, and within 5e-7 of the exact and the libm scaled tanh, whichever
+  // table is in use. Derivatives are taken from these outputs, see activations.h, so need no kernels of their own.
+  // Each element goes through the same arithmetic wherever it sits in x, so a single element gives the same result
+  // as it does within a whole layer.
+  void (*sigmoid)(const float *x, float *y, int n);
+  void (*tanh_scaled)(const float *x, float *y, int n);
+  // One resilient propagation step for n parameters, the rule of Riedmiller and Braun with the constants in
+  // neural_net_constants.h written as selects rather than branches so whole arrays go through at memory speed.
+  // gradient holds the batch gradient sums, which are cleared.
+  void (*rprop)(float *weight, float *gradient, const rprop_state_t &state, int n);
+  // Statistics of the first n_cols columns of n_rows rows, row r starting at x + r * ldx: min[c] and max[c] are
+  // lowered and raised to the column's extremes, and the column's values and their squares are added to sum[c] and
+  // sum_sq[c] in double precision. The rows are vectorized across columns, so each column adds up its values in row
+  // order and the sums, whose squares are exact in double, come out the same from every table.
+  void (*column_stats)(const float *x, long n_rows, long ldx, int n_cols, float *min, float *max, double *sum,
+                       double *sum_sq);
+  // y[i] = x[i] widened to float for n values stored as a Dataset column type, see ColumnTypes. Every value of these
+  // types is a float, so the results are exact and the same from every table. Halves are bits in IEEE binary16.
+  void (*widen_uint8)(const uint8_t *x, float *y, int n);
+  void (*widen_int16)(const int16_t *x, float *y, int n);
+  void (*widen_float16)(const uint16_t *x, float *y, int n);
+} kernels_t;
+
+extern const kernels_t kScalarKernels;
+#if defined(__x86_64__) || defined(__i386__)
+extern const kernels_t kAvx2Kernels;
+extern const kernels_t kAvx512Kernels;
+#endif
+
+// Returns the kernels for the widest instruction set supported by this CPU.
+const kernels_t& Kernels();
+
+}  //namespace neuralplex
+#endif /*KERNELS_H_*/
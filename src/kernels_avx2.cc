@@ -0,0 +1,386 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Built with -mavx2 -mfma, nothing in this file may be called unless CPUID reports both.
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include "fast_math.h"
+#include "kernels.h"
+#include "neural_net_constants.h"
+
+namespace neuralplex {
+
+static inline float HorizontalSum(__m256 v) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+// Four rows are reduced together so each load of x feeds four multiply-adds, with two accumulators per row to
+// keep enough independent FMA chains in flight.
+static void MatVecAvx2(const float *w, const float *x, const float *b, float *y, int rows, int cols) {
+  int r = 0;
+  for (; r + 4 <= rows; r += 4) {
+    const float *w0 = w + (long)r * cols;
+    const float *w1 = w0 + cols;
+    const float *w2 = w1 + cols;
+    const float *w3 = w2 + cols;
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+    __m256 acc4 = _mm256_setzero_ps(), acc5 = _mm256_setzero_ps();
+    __m256 acc6 = _mm256_setzero_ps(), acc7 = _mm256_setzero_ps();
+    int c = 0;
+    for (; c + 16 <= cols; c += 16) {
+      __m256 x0 = _mm256_loadu_ps(x + c);
+      __m256 x1 = _mm256_loadu_ps(x + c + 8);
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + c), x0, acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(w1 + c), x0, acc1);
+      acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(w2 + c), x0, acc2);
+      acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(w3 + c), x0, acc3);
+      acc4 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + c + 8), x1, acc4);
+      acc5 = _mm256_fmadd_ps(_mm256_loadu_ps(w1 + c + 8), x1, acc5);
+      acc6 = _mm256_fmadd_ps(_mm256_loadu_ps(w2 + c + 8), x1, acc6);
+      acc7 = _mm256_fmadd_ps(_mm256_loadu_ps(w3 + c + 8), x1, acc7);
+    }
+    for (; c + 8 <= cols; c += 8) {
+      __m256 x0 = _mm256_loadu_ps(x + c);
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + c), x0, acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(w1 + c), x0, acc1);
+      acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(w2 + c), x0, acc2);
+      acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(w3 + c), x0, acc3);
+    }
+    float s0 = HorizontalSum(_mm256_add_ps(acc0, acc4));
+    float s1 = HorizontalSum(_mm256_add_ps(acc1, acc5));
+    float s2 = HorizontalSum(_mm256_add_ps(acc2, acc6));
+    float s3 = HorizontalSum(_mm256_add_ps(acc3, acc7));
+    for (; c < cols; c++) {
+      s0 += w0[c] * x[c];
+      s1 += w1[c] * x[c];
+      s2 += w2[c] * x[c];
+      s3 += w3[c] * x[c];
+    }
+    y[r] = b[r] + s0;
+    y[r + 1] = b[r + 1] + s1;
+    y[r + 2] = b[r + 2] + s2;
+    y[r + 3] = b[r + 3] + s3;
+  }
+  for (; r < rows; r++) {
+    const float *w0 = w + (long)r * cols;
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    int c = 0;
+    for (; c + 16 <= cols; c += 16) {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + c), _mm256_loadu_ps(x + c), acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + c + 8), _mm256_loadu_ps(x + c + 8), acc1);
+    }
+    for (; c + 8 <= cols; c += 8) acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + c), _mm256_loadu_ps(x + c), acc0);
+    float s0 = HorizontalSum(_mm256_add_ps(acc0, acc1));
+    for (; c < cols; c++) s0 += w0[c] * x[c];
+    y[r] = b[r] + s0;
+  }
+}
+
+static inline float Dot(const float *a, const float *b, int n) {
+  __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+  int c = 0;
+  for (; c + 16 <= n; c += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + c), _mm256_loadu_ps(b + c), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + c + 8), _mm256_loadu_ps(b + c + 8), acc1);
+  }
+  for (; c + 8 <= n; c += 8) acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + c), _mm256_loadu_ps(b + c), acc0);
+  float sum = HorizontalSum(_mm256_add_ps(acc0, acc1));
+  for (; c < n; c++) sum += a[c] * b[c];
+  return sum;
+}
+
+// Each step takes four rows of w against two vectors of x, eight accumulators sharing six loads, and walks every
+// vector of x before moving on to the next four rows so they stay in L1 for the whole batch.
+static void MatMatAvx2(const float *w, const float *x, const float *b, float *y, int rows, int cols, int n_x, long ldx, long ldy) {
+  int r = 0;
+  for (; r + 4 <= rows; r += 4) {
+    const float *w0 = w + (long)r * cols;
+    const float *w1 = w0 + cols;
+    const float *w2 = w1 + cols;
+    const float *w3 = w2 + cols;
+    int i = 0;
+    for (; i + 2 <= n_x; i += 2) {
+      const float *x0 = x + i * ldx;
+      const float *x1 = x0 + ldx;
+      __m256 acc00 = _mm256_setzero_ps(), acc01 = _mm256_setzero_ps();
+      __m256 acc10 = _mm256_setzero_ps(), acc11 = _mm256_setzero_ps();
+      __m256 acc20 = _mm256_setzero_ps(), acc21 = _mm256_setzero_ps();
+      __m256 acc30 = _mm256_setzero_ps(), acc31 = _mm256_setzero_ps();
+      int c = 0;
+      for (; c + 8 <= cols; c += 8) {
+        __m256 xv0 = _mm256_loadu_ps(x0 + c);
+        __m256 xv1 = _mm256_loadu_ps(x1 + c);
+        __m256 wv = _mm256_loadu_ps(w0 + c);
+        acc00 = _mm256_fmadd_ps(wv, xv0, acc00);
+        acc01 = _mm256_fmadd_ps(wv, xv1, acc01);
+        wv = _mm256_loadu_ps(w1 + c);
+        acc10 = _mm256_fmadd_ps(wv, xv0, acc10);
+        acc11 = _mm256_fmadd_ps(wv, xv1, acc11);
+        wv = _mm256_loadu_ps(w2 + c);
+        acc20 = _mm256_fmadd_ps(wv, xv0, acc20);
+        acc21 = _mm256_fmadd_ps(wv, xv1, acc21);
+        wv = _mm256_loadu_ps(w3 + c);
+        acc30 = _mm256_fmadd_ps(wv, xv0, acc30);
+        acc31 = _mm256_fmadd_ps(wv, xv1, acc31);
+      }
+      float s00 = HorizontalSum(acc00), s01 = HorizontalSum(acc01);
+      float s10 = HorizontalSum(acc10), s11 = HorizontalSum(acc11);
+      float s20 = HorizontalSum(acc20), s21 = HorizontalSum(acc21);
+      float s30 = HorizontalSum(acc30), s31 = HorizontalSum(acc31);
+      for (; c < cols; c++) {
+        s00 += w0[c] * x0[c];
+        s01 += w0[c] * x1[c];
+        s10 += w1[c] * x0[c];
+        s11 += w1[c] * x1[c];
+        s20 += w2[c] * x0[c];
+        s21 += w2[c] * x1[c];
+        s30 += w3[c] * x0[c];
+        s31 += w3[c] * x1[c];
+      }
+      float *y0 = y + i * ldy + r;
+      float *y1 = y0 + ldy;
+      y0[0] = b[r] + s00;
+      y0[1] = b[r + 1] + s10;
+      y0[2] = b[r + 2] + s20;
+      y0[3] = b[r + 3] + s30;
+      y1[0] = b[r] + s01;
+      y1[1] = b[r + 1] + s11;
+      y1[2] = b[r + 2] + s21;
+      y1[3] = b[r + 3] + s31;
+    }
+    if (i < n_x) MatVecAvx2(w0, x + i * ldx, b + r, y + i * ldy + r, 4, cols);
+  }
+  for (; r < rows; r++) {
+    const float *w0 = w + (long)r * cols;
+    for (int i = 0; i < n_x; i++) y[i * ldy + r] = b[r] + Dot(w0, x + i * ldx, cols);
+  }
+}
+
+// R rows by 16 columns of c, with the columns past the end of the row masked off by m0 and m1.
+template <int R>
+static inline __attribute__((always_inline)) void GemmTile(const float *a, long a_row, long a_col, const float *b, long ldb, float *c, long ldc,
+                                                           int k, bool accumulate, __m256i m0, __m256i m1) {
+  __m256 acc[R][2];
+  for (int r = 0; r < R; r++) {
+    acc[r][0] = accumulate ? _mm256_maskload_ps(c + r * ldc, m0) : _mm256_setzero_ps();
+    acc[r][1] = accumulate ? _mm256_maskload_ps(c + r * ldc + 8, m1) : _mm256_setzero_ps();
+  }
+  for (int p = 0; p < k; p++) {
+    const float *b_row = b + p * ldb;
+    __m256 b0 = _mm256_maskload_ps(b_row, m0);
+    __m256 b1 = _mm256_maskload_ps(b_row + 8, m1);
+    for (int r = 0; r < R; r++) {
+      __m256 a_rp = _mm256_broadcast_ss(a + r * a_row + p * a_col);
+      acc[r][0] = _mm256_fmadd_ps(a_rp, b0, acc[r][0]);
+      acc[r][1] = _mm256_fmadd_ps(a_rp, b1, acc[r][1]);
+    }
+  }
+  for (int r = 0; r < R; r++) {
+    _mm256_maskstore_ps(c + r * ldc, m0, acc[r][0]);
+    _mm256_maskstore_ps(c + r * ldc + 8, m1, acc[r][1]);
+  }
+}
+
+// Tiles of four rows by sixteen columns, eight accumulators, each b row loaded once per four rows of c.
+static void GemmAvx2(const float *a, long a_row, long a_col, const float *b, long ldb, float *c, long ldc, int m, int n, int k, bool accumulate) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for (int j = 0; j < n; j += 16) {
+    __m256i m0 = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - j), lanes);
+    __m256i m1 = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - j - 8), lanes);
+    int i = 0;
+    for (; i + 4 <= m; i += 4) GemmTile<4>(a + i * a_row, a_row, a_col, b + j, ldb, c + i * ldc + j, ldc, k, accumulate, m0, m1);
+    for (; i < m; i++) GemmTile<1>(a + i * a_row, a_row, a_col, b + j, ldb, c + i * ldc + j, ldc, k, accumulate, m0, m1);
+  }
+}
+
+// exp(x) as in fast_math.h for eight lanes at once.
+static inline __m256 Exp(__m256 x) {
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(kFastExpMin)), _mm256_set1_ps(kFastExpMax));
+  __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(kFastExpLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m256 r = _mm256_fnmadd_ps(k, _mm256_set1_ps(kFastExpLn2Hi), x);
+  r = _mm256_fnmadd_ps(k, _mm256_set1_ps(kFastExpLn2Lo), r);
+  __m256 p = _mm256_set1_ps(kFastExpP0);
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP1));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP2));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP3));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP4));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP5));
+  __m256 y = _mm256_add_ps(_mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r), _mm256_set1_ps(1.0f));
+  __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(scale));
+}
+
+static inline __m256 Sigmoid(__m256 x) {
+  __m256 one = _mm256_set1_ps(1.0f);
+  return _mm256_div_ps(one, _mm256_add_ps(one, Exp(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+}
+
+static inline __m256 Tanh(__m256 x) {
+  __m256 one = _mm256_set1_ps(1.0f);
+  __m256 e = Exp(_mm256_add_ps(x, x));
+  return _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(one, e)));
+}
+
+static inline __m256 TanhScaled(__m256 x) {
+  return _mm256_mul_ps(_mm256_set1_ps(kTanhScaledA), Tanh(_mm256_mul_ps(_mm256_set1_ps(kTanhScaledB), x)));
+}
+
+// Applies F to n floats eight at a time, the ragged end goes through a masked load and store so every element sees
+// the same arithmetic wherever it falls in the array.
+template <__m256 (*F)(__m256)>
+static void Map(const float *x, float *y, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) _mm256_storeu_ps(y + i, F(_mm256_loadu_ps(x + i)));
+  if (i < n) {
+    __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    _mm256_maskstore_ps(y + i, mask, F(_mm256_maskload_ps(x + i, mask)));
+  }
+}
+
+// Eight parameters per iteration with the three cases of the rule as compare masks feeding blends, the ragged end
+// goes through masked loads and stores.
+static void RPropAvx2(float *weight, float *gradient, const rprop_state_t &state, int n) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for (int i = 0; i < n; i += 8) {
+    __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i), lanes);
+    __m256 gradient_batch_sum = _mm256_xor_ps(_mm256_maskload_ps(gradient + i, mask), sign);
+    __m256 last_gradient_batch_sum = _mm256_maskload_ps(state.last_gradient_batch_sum + i, mask);
+    __m256 current_weight = _mm256_add_ps(_mm256_maskload_ps(weight + i, mask), _mm256_maskload_ps(state.next_step + i, mask));
+    __m256 update_val = _mm256_maskload_ps(state.update_val + i, mask);
+    __m256 last_update_val = _mm256_maskload_ps(state.last_update_val + i, mask);
+    __m256 weight_delta = _mm256_maskload_ps(state.weight_delta + i, mask);
+    __m256 last_weight_delta = _mm256_maskload_ps(state.last_weight_delta + i, mask);
+    __m256 rolling_gradient = _mm256_mul_ps(gradient_batch_sum, last_gradient_batch_sum);
+    __m256 faster = _mm256_cmp_ps(rolling_gradient, zero, _CMP_GT_OQ);
+    __m256 slower = _mm256_cmp_ps(rolling_gradient, zero, _CMP_LT_OQ);
+    __m256 next_update_val = _mm256_blendv_ps(update_val, _mm256_min_ps(_mm256_mul_ps(last_update_val, _mm256_set1_ps(kResilientPropFaster)),
+                                                                        _mm256_set1_ps(kResilientPropDeltaMax)), faster);
+    next_update_val = _mm256_blendv_ps(next_update_val, _mm256_max_ps(_mm256_mul_ps(last_update_val, _mm256_set1_ps(kResilientPropSlower)),
+                                                                      _mm256_set1_ps(kResilientPropUpdateMin)), slower);
+    // -sgn(gradient_batch_sum) * next_update_val: the update value with the opposite sign of the gradient, or 0.
+    __m256 step = _mm256_xor_ps(next_update_val, _mm256_andnot_ps(gradient_batch_sum, sign));
+    step = _mm256_and_ps(step, _mm256_cmp_ps(gradient_batch_sum, zero, _CMP_NEQ_OQ));
+    _mm256_maskstore_ps(weight + i, mask, current_weight);
+    _mm256_maskstore_ps(gradient + i, mask, zero);
+    _mm256_maskstore_ps(state.last_gradient_batch_sum + i, mask, _mm256_andnot_ps(slower, gradient_batch_sum));
+    _mm256_maskstore_ps(state.update_val + i, mask, next_update_val);
+    _mm256_maskstore_ps(state.last_update_val + i, mask, _mm256_blendv_ps(last_update_val, update_val, faster));
+    _mm256_maskstore_ps(state.weight_delta + i, mask, _mm256_blendv_ps(step, weight_delta, slower));
+    _mm256_maskstore_ps(state.last_weight_delta + i, mask, _mm256_blendv_ps(weight_delta, last_weight_delta, slower));
+    _mm256_maskstore_ps(state.next_step + i, mask, _mm256_blendv_ps(step, _mm256_xor_ps(last_weight_delta, sign), slower));
+  }
+}
+
+// Eight columns at a time, each widened to two vectors of four doubles for the sums.
+static void ColumnStatsAvx2(const float *x, long n_rows, long ldx, int n_cols, float *min, float *max, double *sum,
+                            double *sum_sq) {
+  for (long r = 0; r < n_rows; r++) {
+    const float *row = x + r * ldx;
+    int c = 0;
+    for (; c + 8 <= n_cols; c += 8) {
+      __m256 v = _mm256_loadu_ps(row + c);
+      _mm256_storeu_ps(min + c, _mm256_min_ps(v, _mm256_loadu_ps(min + c)));
+      _mm256_storeu_ps(max + c, _mm256_max_ps(v, _mm256_loadu_ps(max + c)));
+      __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+      __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+      _mm256_storeu_pd(sum + c, _mm256_add_pd(_mm256_loadu_pd(sum + c), lo));
+      _mm256_storeu_pd(sum + c + 4, _mm256_add_pd(_mm256_loadu_pd(sum + c + 4), hi));
+      _mm256_storeu_pd(sum_sq + c, _mm256_add_pd(_mm256_loadu_pd(sum_sq + c), _mm256_mul_pd(lo, lo)));
+      _mm256_storeu_pd(sum_sq + c + 4, _mm256_add_pd(_mm256_loadu_pd(sum_sq + c + 4), _mm256_mul_pd(hi, hi)));
+    }
+    for (; c < n_cols; c++) {
+      float v = row[c];
+      min[c] = v < min[c] ? v : min[c];
+      max[c] = v > max[c] ? v : max[c];
+      double d = v;
+      sum[c] += d;
+      sum_sq[c] += d * d;
+    }
+  }
+}
+
+static void WidenUint8Avx2(const uint8_t *x, float *y, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i)));
+    _mm256_storeu_ps(y + i, _mm256_cvtepi32_ps(v));
+  }
+  for (; i < n; i++) y[i] = x[i];
+}
+
+static void WidenInt16Avx2(const int16_t *x, float *y, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    _mm256_storeu_ps(y + i, _mm256_cvtepi32_ps(v));
+  }
+  for (; i < n; i++) y[i] = x[i];
+}
+
+// HalfToFloat eight halves at a time, see fast_math.h.
+static void WidenFloat16Avx2(const uint16_t *x, float *y, int n) {
+  const __m256i magnitude_mask = _mm256_set1_epi32(0x7fff);
+  const __m256i sign_mask = _mm256_set1_epi32(0x8000);
+  const __m256i exponent_bits = _mm256_set1_epi32(0x7f800000);
+  const __m256 rebase = _mm256_set1_ps(kHalfRebase);
+  const __m256 infinity = _mm256_set1_ps(kHalfInfinity);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i half = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    __m256 value = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(half, magnitude_mask), 13));
+    value = _mm256_mul_ps(value, rebase);
+    __m256i special = _mm256_castps_si256(_mm256_cmp_ps(value, infinity, _CMP_GE_OQ));
+    __m256i bits = _mm256_or_si256(_mm256_castps_si256(value), _mm256_and_si256(special, exponent_bits));
+    bits = _mm256_or_si256(bits, _mm256_slli_epi32(_mm256_and_si256(half, sign_mask), 16));
+    _mm256_storeu_ps(y + i, _mm256_castsi256_ps(bits));
+  }
+  for (; i < n; i++) y[i] = HalfToFloat(x[i]);
+}
+
+const kernels_t kAvx2Kernels = {
+  "avx2",
+  MatVecAvx2,
+  MatMatAvx2,
+  GemmAvx2,
+  Map<Sigmoid>,
+  Map<TanhScaled>,
+  RPropAvx2,
+  ColumnStatsAvx2,
+  WidenUint8Avx2,
+  WidenInt16Avx2,
+  WidenFloat16Avx2
+};
+
+}  //namespace neuralplex
+#endif
@@ -0,0 +1,354 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Built with -mavx512f -mfma, nothing in this file may be called unless CPUID reports both.
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include "fast_math.h"
+#include "kernels.h"
+#include "neural_net_constants.h"
+
+// GCC 12 reports a false maybe-uninitialized warning from inside the _mm512_reduce_add_ps expansion.
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+namespace neuralplex {
+
+// Mask selecting the first n (0 <= n < 16) lanes, used to load the ragged end of a row without reading past it.
+static inline __mmask16 TailMask(int n) {
+  return (__mmask16)((1u << n) - 1);
+}
+
+// Same blocking as the AVX2 kernel with twice the width, the tail of each row is a single masked load.
+static void MatVecAvx512(const float *w, const float *x, const float *b, float *y, int rows, int cols) {
+  int r = 0;
+  __mmask16 tail = TailMask(cols & 15);
+  int c_end = cols & ~15;
+  for (; r + 4 <= rows; r += 4) {
+    const float *w0 = w + (long)r * cols;
+    const float *w1 = w0 + cols;
+    const float *w2 = w1 + cols;
+    const float *w3 = w2 + cols;
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+    __m512 acc4 = _mm512_setzero_ps(), acc5 = _mm512_setzero_ps();
+    __m512 acc6 = _mm512_setzero_ps(), acc7 = _mm512_setzero_ps();
+    int c = 0;
+    for (; c + 32 <= cols; c += 32) {
+      __m512 x0 = _mm512_loadu_ps(x + c);
+      __m512 x1 = _mm512_loadu_ps(x + c + 16);
+      acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(w0 + c), x0, acc0);
+      acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(w1 + c), x0, acc1);
+      acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(w2 + c), x0, acc2);
+      acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(w3 + c), x0, acc3);
+      acc4 = _mm512_fmadd_ps(_mm512_loadu_ps(w0 + c + 16), x1, acc4);
+      acc5 = _mm512_fmadd_ps(_mm512_loadu_ps(w1 + c + 16), x1, acc5);
+      acc6 = _mm512_fmadd_ps(_mm512_loadu_ps(w2 + c + 16), x1, acc6);
+      acc7 = _mm512_fmadd_ps(_mm512_loadu_ps(w3 + c + 16), x1, acc7);
+    }
+    for (; c < c_end; c += 16) {
+      __m512 x0 = _mm512_loadu_ps(x + c);
+      acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(w0 + c), x0, acc0);
+      acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(w1 + c), x0, acc1);
+      acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(w2 + c), x0, acc2);
+      acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(w3 + c), x0, acc3);
+    }
+    if (tail) {
+      __m512 x0 = _mm512_maskz_loadu_ps(tail, x + c);
+      acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, w0 + c), x0, acc0);
+      acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, w1 + c), x0, acc1);
+      acc2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, w2 + c), x0, acc2);
+      acc3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, w3 + c), x0, acc3);
+    }
+    y[r] = b[r] + _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc4));
+    y[r + 1] = b[r + 1] + _mm512_reduce_add_ps(_mm512_add_ps(acc1, acc5));
+    y[r + 2] = b[r + 2] + _mm512_reduce_add_ps(_mm512_add_ps(acc2, acc6));
+    y[r + 3] = b[r + 3] + _mm512_reduce_add_ps(_mm512_add_ps(acc3, acc7));
+  }
+  for (; r < rows; r++) {
+    const float *w0 = w + (long)r * cols;
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    int c = 0;
+    for (; c + 32 <= cols; c += 32) {
+      acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(w0 + c), _mm512_loadu_ps(x + c), acc0);
+      acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(w0 + c + 16), _mm512_loadu_ps(x + c + 16), acc1);
+    }
+    for (; c < c_end; c += 16) acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(w0 + c), _mm512_loadu_ps(x + c), acc0);
+    if (tail) acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, w0 + c), _mm512_maskz_loadu_ps(tail, x + c), acc1);
+    y[r] = b[r] + _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+  }
+}
+
+static inline float Dot(const float *a, const float *b, int n) {
+  __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+  int c = 0;
+  for (; c + 32 <= n; c += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + c), _mm512_loadu_ps(b + c), acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + c + 16), _mm512_loadu_ps(b + c + 16), acc1);
+  }
+  for (; c + 16 <= n; c += 16) acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + c), _mm512_loadu_ps(b + c), acc0);
+  __mmask16 tail = TailMask(n - c);
+  if (tail) acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a + c), _mm512_maskz_loadu_ps(tail, b + c), acc1);
+  return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+// Multiplies 16 columns of four rows of w, the first at w with a stride of cols, against 16 columns of four vectors
+// of x, the first at x with a stride of ldx, adding into the sixteen accumulators acc[row * 4 + vector].
+static inline __attribute__((always_inline)) void Tile4x4(const float *w, int cols, const float *x, long ldx, __mmask16 mask, __m512 *acc) {
+  __m512 xv0 = _mm512_maskz_loadu_ps(mask, x);
+  __m512 xv1 = _mm512_maskz_loadu_ps(mask, x + ldx);
+  __m512 xv2 = _mm512_maskz_loadu_ps(mask, x + 2 * ldx);
+  __m512 xv3 = _mm512_maskz_loadu_ps(mask, x + 3 * ldx);
+  for (int n = 0; n < 4; n++) {
+    __m512 wv = _mm512_maskz_loadu_ps(mask, w + n * cols);
+    acc[n * 4] = _mm512_fmadd_ps(wv, xv0, acc[n * 4]);
+    acc[n * 4 + 1] = _mm512_fmadd_ps(wv, xv1, acc[n * 4 + 1]);
+    acc[n * 4 + 2] = _mm512_fmadd_ps(wv, xv2, acc[n * 4 + 2]);
+    acc[n * 4 + 3] = _mm512_fmadd_ps(wv, xv3, acc[n * 4 + 3]);
+  }
+}
+
+// Each step takes four rows of w against four vectors of x, sixteen accumulators sharing eight loads, and walks
+// every vector of x before moving on to the next four rows so they stay in L1 for the whole batch.
+static void MatMatAvx512(const float *w, const float *x, const float *b, float *y, int rows, int cols, int n_x, long ldx, long ldy) {
+  __mmask16 tail = TailMask(cols & 15);
+  int c_end = cols & ~15;
+  int r = 0;
+  for (; r + 4 <= rows; r += 4) {
+    const float *w0 = w + (long)r * cols;
+    int i = 0;
+    for (; i + 4 <= n_x; i += 4) {
+      const float *x0 = x + i * ldx;
+      __m512 acc[16];
+      for (int k = 0; k < 16; k++) acc[k] = _mm512_setzero_ps();
+      for (int c = 0; c < c_end; c += 16) Tile4x4(w0 + c, cols, x0 + c, ldx, 0xFFFF, acc);
+      if (tail) Tile4x4(w0 + c_end, cols, x0 + c_end, ldx, tail, acc);
+      for (int n = 0; n < 4; n++) {
+        for (int k = 0; k < 4; k++) y[(i + k) * ldy + r + n] = b[r + n] + _mm512_reduce_add_ps(acc[n * 4 + k]);
+      }
+    }
+    for (; i < n_x; i++) MatVecAvx512(w0, x + i * ldx, b + r, y + i * ldy + r, 4, cols);
+  }
+  for (; r < rows; r++) {
+    const float *w0 = w + (long)r * cols;
+    for (int i = 0; i < n_x; i++) y[i * ldy + r] = b[r] + Dot(w0, x + i * ldx, cols);
+  }
+}
+
+// R rows by 32 columns of c, with the columns past the end of the row masked off by m0 and m1.
+template <int R>
+static inline __attribute__((always_inline)) void GemmTile(const float *a, long a_row, long a_col, const float *b, long ldb, float *c, long ldc,
+                                                           int k, bool accumulate, __mmask16 m0, __mmask16 m1) {
+  __m512 acc[R][2];
+  for (int r = 0; r < R; r++) {
+    acc[r][0] = accumulate ? _mm512_maskz_loadu_ps(m0, c + r * ldc) : _mm512_setzero_ps();
+    acc[r][1] = accumulate ? _mm512_maskz_loadu_ps(m1, c + r * ldc + 16) : _mm512_setzero_ps();
+  }
+  for (int p = 0; p < k; p++) {
+    const float *b_row = b + p * ldb;
+    __m512 b0 = _mm512_maskz_loadu_ps(m0, b_row);
+    __m512 b1 = _mm512_maskz_loadu_ps(m1, b_row + 16);
+    for (int r = 0; r < R; r++) {
+      __m512 a_rp = _mm512_set1_ps(a[r * a_row + p * a_col]);
+      acc[r][0] = _mm512_fmadd_ps(a_rp, b0, acc[r][0]);
+      acc[r][1] = _mm512_fmadd_ps(a_rp, b1, acc[r][1]);
+    }
+  }
+  for (int r = 0; r < R; r++) {
+    _mm512_mask_storeu_ps(c + r * ldc, m0, acc[r][0]);
+    _mm512_mask_storeu_ps(c + r * ldc + 16, m1, acc[r][1]);
+  }
+}
+
+// Same tiling as the AVX2 kernel with thirty-two columns per tile.
+static void GemmAvx512(const float *a, long a_row, long a_col, const float *b, long ldb, float *c, long ldc, int m, int n, int k, bool accumulate) {
+  for (int j = 0; j < n; j += 32) {
+    int rest = n - j;
+    __mmask16 m0 = rest >= 16 ? (__mmask16)0xffff : TailMask(rest);
+    __mmask16 m1 = rest >= 32 ? (__mmask16)0xffff : rest > 16 ? TailMask(rest - 16) : (__mmask16)0;
+    int i = 0;
+    for (; i + 4 <= m; i += 4) GemmTile<4>(a + i * a_row, a_row, a_col, b + j, ldb, c + i * ldc + j, ldc, k, accumulate, m0, m1);
+    for (; i < m; i++) GemmTile<1>(a + i * a_row, a_row, a_col, b + j, ldb, c + i * ldc + j, ldc, k, accumulate, m0, m1);
+  }
+}
+
+// exp(x) as in fast_math.h for sixteen lanes at once.
+static inline __m512 Exp(__m512 x) {
+  x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(kFastExpMin)), _mm512_set1_ps(kFastExpMax));
+  __m512 k = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(kFastExpLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m512 r = _mm512_fnmadd_ps(k, _mm512_set1_ps(kFastExpLn2Hi), x);
+  r = _mm512_fnmadd_ps(k, _mm512_set1_ps(kFastExpLn2Lo), r);
+  __m512 p = _mm512_set1_ps(kFastExpP0);
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kFastExpP1));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kFastExpP2));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kFastExpP3));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kFastExpP4));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kFastExpP5));
+  __m512 y = _mm512_add_ps(_mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r), _mm512_set1_ps(1.0f));
+  return _mm512_scalef_ps(y, k);
+}
+
+static inline __m512 Sigmoid(__m512 x) {
+  __m512 one = _mm512_set1_ps(1.0f);
+  return _mm512_div_ps(one, _mm512_add_ps(one, Exp(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+}
+
+static inline __m512 Tanh(__m512 x) {
+  __m512 one = _mm512_set1_ps(1.0f);
+  __m512 e = Exp(_mm512_add_ps(x, x));
+  return _mm512_sub_ps(one, _mm512_div_ps(_mm512_set1_ps(2.0f), _mm512_add_ps(one, e)));
+}
+
+static inline __m512 TanhScaled(__m512 x) {
+  return _mm512_mul_ps(_mm512_set1_ps(kTanhScaledA), Tanh(_mm512_mul_ps(_mm512_set1_ps(kTanhScaledB), x)));
+}
+
+// Applies F to n floats sixteen at a time with a masked tail.
+template <__m512 (*F)(__m512)>
+static void Map(const float *x, float *y, int n) {
+  int i = 0;
+  for (; i + 16 <= n; i += 16) _mm512_storeu_ps(y + i, F(_mm512_loadu_ps(x + i)));
+  if (i < n) {
+    __mmask16 mask = TailMask(n - i);
+    _mm512_mask_storeu_ps(y + i, mask, F(_mm512_maskz_loadu_ps(mask, x + i)));
+  }
+}
+
+// As the AVX2 kernel, with the cases of the rule held in mask registers.
+static void RPropAvx512(float *weight, float *gradient, const rprop_state_t &state, int n) {
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512i sign = _mm512_set1_epi32(0x80000000);
+  for (int i = 0; i < n; i += 16) {
+    __mmask16 mask = n - i < 16 ? TailMask(n - i) : (__mmask16)0xffff;
+    __m512 gradient_batch_sum = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_maskz_loadu_ps(mask, gradient + i)), sign));
+    __m512 last_gradient_batch_sum = _mm512_maskz_loadu_ps(mask, state.last_gradient_batch_sum + i);
+    __m512 current_weight = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, weight + i), _mm512_maskz_loadu_ps(mask, state.next_step + i));
+    __m512 update_val = _mm512_maskz_loadu_ps(mask, state.update_val + i);
+    __m512 last_update_val = _mm512_maskz_loadu_ps(mask, state.last_update_val + i);
+    __m512 weight_delta = _mm512_maskz_loadu_ps(mask, state.weight_delta + i);
+    __m512 last_weight_delta = _mm512_maskz_loadu_ps(mask, state.last_weight_delta + i);
+    __m512 rolling_gradient = _mm512_mul_ps(gradient_batch_sum, last_gradient_batch_sum);
+    __mmask16 faster = _mm512_cmp_ps_mask(rolling_gradient, zero, _CMP_GT_OQ);
+    __mmask16 slower = _mm512_cmp_ps_mask(rolling_gradient, zero, _CMP_LT_OQ);
+    __m512 next_update_val = _mm512_mask_blend_ps(faster, update_val, _mm512_min_ps(_mm512_mul_ps(last_update_val, _mm512_set1_ps(kResilientPropFaster)),
+                                                                                    _mm512_set1_ps(kResilientPropDeltaMax)));
+    next_update_val = _mm512_mask_blend_ps(slower, next_update_val, _mm512_max_ps(_mm512_mul_ps(last_update_val, _mm512_set1_ps(kResilientPropSlower)),
+                                                                                  _mm512_set1_ps(kResilientPropUpdateMin)));
+    // -sgn(gradient_batch_sum) * next_update_val: the update value with the opposite sign of the gradient, or 0.
+    __m512i opposite_sign = _mm512_andnot_si512(_mm512_castps_si512(gradient_batch_sum), sign);
+    __m512 step = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(gradient_batch_sum, zero, _CMP_NEQ_OQ),
+                                      _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(next_update_val), opposite_sign)));
+    _mm512_mask_storeu_ps(weight + i, mask, current_weight);
+    _mm512_mask_storeu_ps(gradient + i, mask, zero);
+    _mm512_mask_storeu_ps(state.last_gradient_batch_sum + i, mask, _mm512_mask_mov_ps(gradient_batch_sum, slower, zero));
+    _mm512_mask_storeu_ps(state.update_val + i, mask, next_update_val);
+    _mm512_mask_storeu_ps(state.last_update_val + i, mask, _mm512_mask_blend_ps(faster, last_update_val, update_val));
+    _mm512_mask_storeu_ps(state.weight_delta + i, mask, _mm512_mask_blend_ps(slower, step, weight_delta));
+    _mm512_mask_storeu_ps(state.last_weight_delta + i, mask, _mm512_mask_blend_ps(slower, weight_delta, last_weight_delta));
+    __m512 undo_step = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(last_weight_delta), sign));
+    _mm512_mask_storeu_ps(state.next_step + i, mask, _mm512_mask_blend_ps(slower, step, undo_step));
+  }
+}
+
+// Sixteen columns at a time, the last partial group masked, each widened to two vectors of eight doubles for the sums.
+static void ColumnStatsAvx512(const float *x, long n_rows, long ldx, int n_cols, float *min, float *max, double *sum,
+                              double *sum_sq) {
+  for (long r = 0; r < n_rows; r++) {
+    const float *row = x + r * ldx;
+    for (int c = 0; c < n_cols; c += 16) {
+      __mmask16 m = n_cols - c >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (n_cols - c)) - 1);
+      __mmask8 m_lo = (__mmask8)m;
+      __mmask8 m_hi = (__mmask8)(m >> 8);
+      __m512 v = _mm512_maskz_loadu_ps(m, row + c);
+      _mm512_mask_storeu_ps(min + c, m, _mm512_min_ps(v, _mm512_maskz_loadu_ps(m, min + c)));
+      _mm512_mask_storeu_ps(max + c, m, _mm512_max_ps(v, _mm512_maskz_loadu_ps(m, max + c)));
+      __m512d lo = _mm512_cvtps_pd(_mm512_castps512_ps256(v));
+      __m512d hi = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+      _mm512_mask_storeu_pd(sum + c, m_lo, _mm512_add_pd(_mm512_maskz_loadu_pd(m_lo, sum + c), lo));
+      _mm512_mask_storeu_pd(sum + c + 8, m_hi, _mm512_add_pd(_mm512_maskz_loadu_pd(m_hi, sum + c + 8), hi));
+      _mm512_mask_storeu_pd(sum_sq + c, m_lo,
+                            _mm512_add_pd(_mm512_maskz_loadu_pd(m_lo, sum_sq + c), _mm512_mul_pd(lo, lo)));
+      _mm512_mask_storeu_pd(sum_sq + c + 8, m_hi,
+                            _mm512_add_pd(_mm512_maskz_loadu_pd(m_hi, sum_sq + c + 8), _mm512_mul_pd(hi, hi)));
+    }
+  }
+}
+
+static void WidenUint8Avx512(const uint8_t *x, float *y, int n) {
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i v = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    _mm512_storeu_ps(y + i, _mm512_cvtepi32_ps(v));
+  }
+  for (; i < n; i++) y[i] = x[i];
+}
+
+static void WidenInt16Avx512(const int16_t *x, float *y, int n) {
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i v = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+    _mm512_storeu_ps(y + i, _mm512_cvtepi32_ps(v));
+  }
+  for (; i < n; i++) y[i] = x[i];
+}
+
+// HalfToFloat sixteen halves at a time, see fast_math.h.
+static void WidenFloat16Avx512(const uint16_t *x, float *y, int n) {
+  const __m512i magnitude_mask = _mm512_set1_epi32(0x7fff);
+  const __m512i sign_mask = _mm512_set1_epi32(0x8000);
+  const __m512i exponent_bits = _mm512_set1_epi32(0x7f800000);
+  const __m512 rebase = _mm512_set1_ps(kHalfRebase);
+  const __m512 infinity = _mm512_set1_ps(kHalfInfinity);
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i half = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+    __m512 value = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_and_si512(half, magnitude_mask), 13));
+    value = _mm512_mul_ps(value, rebase);
+    __mmask16 special = _mm512_cmp_ps_mask(value, infinity, _CMP_GE_OQ);
+    __m512i bits = _mm512_mask_or_epi32(_mm512_castps_si512(value), special, _mm512_castps_si512(value), exponent_bits);
+    bits = _mm512_or_si512(bits, _mm512_slli_epi32(_mm512_and_si512(half, sign_mask), 16));
+    _mm512_storeu_ps(y + i, _mm512_castsi512_ps(bits));
+  }
+  for (; i < n; i++) y[i] = HalfToFloat(x[i]);
+}
+
+const kernels_t kAvx512Kernels = {
+  "avx512",
+  MatVecAvx512,
+  MatMatAvx512,
+  GemmAvx512,
+  Map<Sigmoid>,
+  Map<TanhScaled>,
+  RPropAvx512,
+  ColumnStatsAvx512,
+  WidenUint8Avx512,
+  WidenInt16Avx512,
+  WidenFloat16Avx512
+};
+
+}  //namespace neuralplex
+#endif
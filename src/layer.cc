@@ -0,0 +1,193 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include "layer.h"
+
+namespace neuralplex {
+
+Layer::Layer(std::string name, std::string bias_name, int idx, int n_neurons, Layer *below, const Activation *activation,
+             Arena *arena, float *params) {
+  name_ = name;
+  bias_name_ = bias_name;
+  idx_ = idx;
+  n_neurons_ = n_neurons;
+  n_inputs_ = below ? below->n_neurons() : 0;
+  n_params_ = below ? n_neurons_ * (n_inputs_ + 1) : 0;
+  below_ = below;
+  above_ = NULL;
+  if (below_) below_->above_ = this;
+  activation_ = activation;
+  kernels_ = &Kernels();
+  InitActivations(&workspace_, 1, arena);
+  workspace_.gradients = NULL;
+  if (params) {
+    params_ = params;
+  } else {
+    params_ = arena->AllocateFloats(n_params_);
+    InitGradients(arena);
+  }
+}
+
+Layer::~Layer() {}
+
+// A one row workspace, then the parameters and their gradient sums when the layer owns its parameters.
+size_t Layer::ArenaSize(int n_neurons, int n_inputs, bool own_params) {
+  size_t n_params = n_inputs ? n_neurons * (n_inputs + 1) : 0;
+  size_t size = 5 * Arena::Aligned(n_neurons * sizeof(float));
+  if (own_params) size += 2 * Arena::Aligned(n_params * sizeof(float));
+  return size;
+}
+
+void Layer::InitGradients(Arena *arena) {
+  workspace_.gradients = arena->AllocateFloats(n_params_);
+}
+
+size_t Layer::WorkspaceArenaSize(int n_rows) const {
+  return 5 * Arena::Aligned((size_t)n_rows * n_neurons_ * sizeof(float)) + Arena::Aligned(n_params_ * sizeof(float));
+}
+
+void Layer::InitWorkspace(workspace_t *workspace, int n_rows, Arena *arena) const {
+  InitActivations(workspace, n_rows, arena);
+  workspace->gradients = arena->AllocateFloats(n_params_);
+}
+
+void Layer::InitActivations(workspace_t *workspace, int n_rows, Arena *arena) const {
+  workspace->summation = arena->AllocateFloats((size_t)n_rows * n_neurons_);
+  workspace->output = arena->AllocateFloats((size_t)n_rows * n_neurons_);
+  workspace->error = arena->AllocateFloats((size_t)n_rows * n_neurons_);
+  workspace->delta = arena->AllocateFloats((size_t)n_rows * n_neurons_);
+  workspace->ideal = arena->AllocateFloats((size_t)n_rows * n_neurons_);
+}
+
+void Layer::SetParams(const float *params) {
+  std::copy(params, params + n_params_, params_);
+}
+
+void Layer::set_weight(int n, int x, float weight) {
+  params_[n * n_inputs_ + x] = weight;
+}
+
+void Layer::set_bias(int n, float bias) {
+  params_[n_neurons_ * n_inputs_ + n] = bias;
+}
+
+void Layer::Forward(const workspace_t &below, workspace_t *workspace, int n_rows) const {
+  if (!below_) return;
+  const float *biases = &params_[n_neurons_ * n_inputs_];
+  if (n_rows == 1) {
+    kernels_->mat_vec(&params_[0], &below.output[0], biases, &workspace->summation[0], n_neurons_, n_inputs_);
+  } else {
+    kernels_->mat_mat(&params_[0], &below.output[0], biases, &workspace->summation[0], n_neurons_, n_inputs_, n_rows, n_inputs_, n_neurons_);
+  }
+  activation_->Activate(&workspace->summation[0], &workspace->output[0], n_rows * n_neurons_);
+}
+
+void Layer::ForwardBatch(const float *in, long ld_in, float *out, long ld_out, int n_rows) const {
+  if (!below_) return;
+  kernels_->mat_mat(&params_[0], in, &params_[n_neurons_ * n_inputs_], out, n_neurons_, n_inputs_, n_rows, ld_in, ld_out);
+  for (int row = 0; row < n_rows; row++) {
+    float *outputs = out + row * ld_out;
+    activation_->Activate(outputs, outputs, n_neurons_);
+  }
+}
+
+void Layer::Backward(const workspace_t &below, const workspace_t *above, workspace_t *workspace, int n_rows) const {
+  if (!below_) return;
+  int n_values = n_rows * n_neurons_;
+  float *error = &workspace->error[0];
+  float *delta = &workspace->delta[0];
+  activation_->Derivative(&workspace->summation[0], &workspace->output[0], delta, n_values);
+  if (!above) {
+    for (int x = 0; x < n_values; x++) error[x] = workspace->ideal[x] - workspace->output[x];
+  } else {
+    // error = deltas above * weights above, the weights being read in place as n_neurons_ wide rows.
+    kernels_->gemm(&above->delta[0], above_->n_neurons(), 1, &above_->params_[0], n_neurons_, error, n_neurons_,
+                   n_rows, n_neurons_, above_->n_neurons(), false);
+  }
+  for (int x = 0; x < n_values; x++) delta[x] = error[x] * delta[x];
+  // gradients += deltas transposed * outputs below, the bias gradients being the deltas summed over the rows.
+  kernels_->gemm(delta, 1, n_neurons_, &below.output[0], n_inputs_, &workspace->gradients[0], n_inputs_,
+                 n_neurons_, n_inputs_, n_rows, true);
+  float *bias_gradients = &workspace->gradients[n_neurons_ * n_inputs_];
+  for (int row = 0; row < n_rows; row++) {
+    for (int n = 0; n < n_neurons_; n++) bias_gradients[n] += delta[row * n_neurons_ + n];
+  }
+}
+
+void Layer::KeepRow(const workspace_t &workspace, int row) {
+  int begin = row * n_neurons_;
+  int end = begin + n_neurons_;
+  std::copy(workspace.summation + begin, workspace.summation + end, workspace_.summation);
+  std::copy(workspace.output + begin, workspace.output + end, workspace_.output);
+  std::copy(workspace.error + begin, workspace.error + end, workspace_.error);
+  std::copy(workspace.delta + begin, workspace.delta + end, workspace_.delta);
+  std::copy(workspace.ideal + begin, workspace.ideal + end, workspace_.ideal);
+}
+
+void Layer::AddGradients(workspace_t *workspace) {
+  for (int x = 0; x < n_params_; x++) {
+    workspace_.gradients[x] += workspace->gradients[x];
+    workspace->gradients[x] = 0.0f;
+  }
+}
+
+void Layer::Forward(int n) {
+  if (below_) Forward(n, below_->workspace_, &workspace_);
+}
+
+void Layer::Backward(int n) {
+  if (below_) Backward(n, below_->workspace_, above_ ? &above_->workspace_ : NULL, &workspace_);
+}
+
+void Layer::Forward(int n, const workspace_t &below, workspace_t *workspace) const {
+  const float *weights = &params_[n * n_inputs_];
+  float summation = bias(n);
+  for (int x = 0; x < n_inputs_; x++) summation += below.output[x] * weights[x];
+  workspace->summation[n] = summation;
+  workspace->output[n] = activation_->Activate(summation);
+}
+
+void Layer::Backward(int n, const workspace_t &below, const workspace_t *above, workspace_t *workspace) const {
+  // Nothing reads the delta of an input neuron, so the input layer has no backward step.
+  if (!below_) return;
+  if (!above) {
+    workspace->error[n] = workspace->ideal[n] - workspace->output[n];
+    workspace->delta[n] = workspace->error[n] * activation_->Derivative(workspace->summation[n], workspace->output[n]);
+  } else {
+    float error = 0.0f;
+    for (int x = 0; x < above_->n_neurons(); x++) error += above->delta[x] * above_->weight(x, n);
+    workspace->error[n] = error;
+    workspace->delta[n] = error * activation_->Derivative(workspace->summation[n], workspace->output[n]);
+  }
+  float *gradients = &workspace->gradients[n * n_inputs_];
+  for (int x = 0; x < n_inputs_; x++) gradients[x] += below.output[x] * workspace->delta[n];
+  workspace->gradients[n_neurons_ * n_inputs_ + n] += workspace->delta[n];
+}
+
+}  //namespace neuralplex
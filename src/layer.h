@@ -0,0 +1,188 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LAYER_H_
+#define LAYER_H_
+
+#include<stdlib.h>
+#include<string>
+#include<vector>
+#include "activations.h"
+#include "arena.h"
+#include "kernels.h"
+
+namespace neuralplex {
+
+// Layer owns every weight feeding one layer of neurons. Weights are kept once, in a contiguous row-major
+// matrix with one row per neuron in this layer and one column per neuron in the layer below, followed by
+// the bias vector which takes the place of a bias neuron connected to each neuron in this layer. The
+// batch gradient sums, and the learning state an Optimizer keeps, are laid out in the same order so that a
+// neuron's fan-in, bias included, is a single contiguous run of parameters. The input layer has no layer below it
+// and so carries no weights, its outputs are written directly with set_input.
+// The activations of a row and the batch gradient sums live in a workspace_t rather than in the layer, so
+// several training workers can push rows through the same weights at once. The layer has a workspace of its
+// own which the per neuron methods, Compute and the JSON representation use.
+// Every array a layer uses is carved from an Arena owned by the network, see ArenaSize, unless the parameters are
+// handed in from elsewhere, such as a mapped model file. Such a layer has no gradient sums, and so cannot train,
+// until InitGradients gives it some.
+class Layer {
+ public:
+  // Activations of a tile of rows through the layer, row i of each field starting at i * n_neurons, and the
+  // gradients of the layer's parameters summed over the rows seen since they were last applied. The error of a
+  // hidden neuron is the deltas of the layer above weighted back through their weights. The layer's own workspace
+  // holds a single row.
+  typedef struct {
+    float *summation;
+    float *output;
+    float *error;
+    float *delta;
+    float *ideal;
+    float *gradients;
+  } workspace_t;
+
+  // Read-only view of a matrix of parameters kept by a layer, element (row, col) being
+  // data[row * row_stride + col * col_stride]. A view reads the layer's own storage, so it sees every later change
+  // to the parameters and is valid for as long as the layer is.
+  typedef struct {
+    const float *data;
+    int n_rows;
+    int n_cols;
+    long row_stride;
+    long col_stride;
+  } params_view_t;
+
+  //Layer(): construct a new Layer
+  // name: prefix used to name the neurons in this layer, neuron n is called name followed by n.
+  // bias_name: name reported for the bias feeding this layer.
+  // idx: position of the layer in the network, 0 being the input layer.
+  // n_neurons: number of neurons in this layer
+  // below: the layer feeding this one or NULL for the input layer
+  // activation: the activation function and its derivative, owned by the network
+  // arena: where the parameters and workspace of the layer are allocated, ArenaSize(n_neurons,
+  //   n_inputs, params == NULL) bytes of it.
+  // params: optional storage of the layer's parameters, in the layer's order, used in place and not owned.
+  Layer(std::string name, std::string bias_name, int idx, int n_neurons, Layer *below, const Activation *activation,
+        Arena *arena, float *params = NULL);
+  virtual ~Layer();
+  // Bytes of arena a layer of n_neurons fed by n_inputs neurons allocates, 0 n_inputs for the input layer.
+  // own_params: false for a layer given its parameters, which allocates neither them nor gradient sums.
+  static size_t ArenaSize(int n_neurons, int n_inputs, bool own_params = true);
+  // Allocates the gradient sums of a layer given its parameters from arena, n_params() floats of it.
+  void InitGradients(Arena *arena);
+  bool has_gradients() const { return workspace_.gradients != NULL; }
+  // Bytes of arena a workspace for a tile of n_rows rows through this layer takes.
+  size_t WorkspaceArenaSize(int n_rows) const;
+  // Allocates workspace for a tile of n_rows rows through this layer from arena, zeroed.
+  void InitWorkspace(workspace_t *workspace, int n_rows, Arena *arena) const;
+  // Calculates the summation and output of every neuron in the layer for the first n_rows rows of the workspace,
+  // as one matrix-vector product for a single row or one blocked matrix-matrix product for a tile.
+  void Forward() { if (below_) Forward(below_->workspace_, &workspace_); }
+  void Forward(const workspace_t &below, workspace_t *workspace, int n_rows = 1) const;
+  // Calculates the output of every neuron in the layer for n_rows rows at once without touching the layer's own
+  // state. Row i of the outputs of the layer below starts at in + i * ld_in and row i of the outputs of this layer is
+  // written to out + i * ld_out.
+  void ForwardBatch(const float *in, long ld_in, float *out, long ld_out, int n_rows) const;
+  // Runs the backward step of every neuron in the layer for the first n_rows rows of the workspace. above is the
+  // workspace of the layer above, NULL for the output layer. The errors of a hidden layer and the gradients are
+  // each a single matrix product over the tile.
+  void Backward() { if (below_) Backward(below_->workspace_, above_ ? &above_->workspace_ : NULL, &workspace_); }
+  void Backward(const workspace_t &below, const workspace_t *above, workspace_t *workspace, int n_rows = 1) const;
+  // Copies row row of workspace, gradients aside, into the layer's own workspace.
+  void KeepRow(const workspace_t &workspace, int row);
+  // Adds the batch gradient sums of workspace into the layer's own and clears them in workspace.
+  void AddGradients(workspace_t *workspace);
+  // Calculates the summation and output of neuron n from the outputs of the layer below.
+  void Forward(int n);
+  // Calculates the delta of neuron n, which requires the layer above to have completed its backward
+  // step, and adds the gradients of the weights feeding neuron n to their running batch sums.
+  void Backward(int n);
+  std::string name() const { return name_; }
+  std::string bias_name() const { return bias_name_; }
+  std::string neuron_name(int n) const { return name_ + std::to_string(n); }
+  int idx() const { return idx_; }
+  int n_neurons() const { return n_neurons_; }
+  int n_inputs() const { return n_inputs_; }
+  // Number of weights and biases feeding the layer.
+  int n_params() const { return n_params_; }
+  // Weights and biases feeding the layer in storage order.
+  const float* params() const { return params_; }
+  float* mutable_params() { return params_; }
+  // Copies n_params() values from params, weights then biases in storage order, over the layer's parameters.
+  void SetParams(const float *params);
+  // The weights as an n_neurons by n_inputs matrix, a row per neuron of this layer.
+  params_view_t weights_view() const {
+    params_view_t view = {params_, n_neurons_, n_inputs_, n_inputs_, 1};
+    return view;
+  }
+  // The biases as an n_neurons by 1 matrix.
+  params_view_t biases_view() const {
+    params_view_t view = {params_ + n_neurons_ * n_inputs_, n_neurons_, 1, 1, 1};
+    return view;
+  }
+  Layer* below() const { return below_; }
+  Layer* above() const { return above_; }
+  workspace_t* workspace() { return &workspace_; }
+  // Weight between neuron n of this layer and neuron x of the layer below.
+  float weight(int n, int x) const { return params_[n * n_inputs_ + x]; }
+  void set_weight(int n, int x, float weight);
+  float bias(int n) const { return params_[n_neurons_ * n_inputs_ + n]; }
+  void set_bias(int n, float bias);
+  // Sets the count parameters from begin, weights then biases in storage order, to successive values of generator().
+  template <class Generator>
+  void FillParams(int begin, int count, Generator &generator) {
+    for (int i = begin; i < begin + count; i++) params_[i] = generator();
+  }
+  float summation(int n) const { return workspace_.summation[n]; }
+  float output(int n) const { return workspace_.output[n]; }
+  float error(int n) const { return workspace_.error[n]; }
+  float delta(int n) const { return workspace_.delta[n]; }
+  float ideal(int n) const { return workspace_.ideal[n]; }
+  void set_input(int n, float input) { workspace_.summation[n] = input; workspace_.output[n] = input; }
+  void set_ideal(int n, float ideal) { workspace_.ideal[n] = ideal; }
+
+ private:
+  // Allocates the activations of a workspace, every field but the gradients.
+  void InitActivations(workspace_t *workspace, int n_rows, Arena *arena) const;
+  void Forward(int n, const workspace_t &below, workspace_t *workspace) const;
+  void Backward(int n, const workspace_t &below, const workspace_t *above, workspace_t *workspace) const;
+  std::string name_;
+  std::string bias_name_;
+  int idx_;
+  int n_neurons_;
+  int n_inputs_;
+  int n_params_;
+  Layer *below_;
+  Layer *above_;
+  const Activation *activation_;
+  const kernels_t *kernels_;
+  // n_neurons_ * n_inputs_ weights in row-major order followed by n_neurons_ biases.
+  float *params_;
+  workspace_t workspace_;
+};
+
+}  //namespace neuralplex
+#endif /*LAYER_H_*/
@@ -0,0 +1,153 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MODEL_FILE_H_
+#define MODEL_FILE_H_
+
+#include <stdint.h>
+
+namespace neuralplex {
+
+// A model file holds a model_file_header_t followed by the parameters of the hidden layer and of the output layer,
+// each in the layer's storage order, row-major weights then biases, then the n_input input scales followed by the
+// n_input input offsets the network normalizes its inputs with, each array starting on a kModelFileAlignment byte
+// boundary. A mapping of the file is page aligned, so the parameters in it are aligned for the kernels and serve as
+// the layers' parameter storage as they are, see NeuralNet::MapModel. Fields are written in the byte order of the
+// machine that saved the file, which byte_order records so that a foreign file is refused rather than misread.
+const char kModelFileMagic[8] = {'N', 'P', 'L', 'X', 'M', 'O', 'D', 'L'};
+const uint32_t kModelFileVersion = 2;
+const uint32_t kModelFileByteOrder = 0x01020304;
+const uint64_t kModelFileAlignment = 64;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t header_size;
+  int32_t n_input;
+  int32_t n_hidden;
+  int32_t n_output;
+  // One of ActivationIds, shared by every layer.
+  int32_t activation;
+  // One of Normalizations, how the input scales and offsets were found.
+  int32_t normalization;
+  int32_t epoch;
+  // Bounds of all the training inputs.
+  float max_float_training;
+  float min_float_training;
+  // Byte offsets of the parameters of the hidden and the output layer and of the input scales from the start of
+  // the file.
+  uint64_t hidden_params_offset;
+  uint64_t output_params_offset;
+  uint64_t normalization_offset;
+} model_file_header_t;
+
+// A model delta file turns one network into another of the same topology by rewriting only the parameters that
+// changed. It holds a model_delta_header_t followed by n_changes parameter indices, as uint32_t in increasing order,
+// then the n_changes new values of those parameters as floats, then the n_input input scales and the n_input input
+// offsets of the network it was taken from. Parameters are counted through the hidden layer's
+// then the output layer's, each in storage order, as in a model file. A delta only applies to the parameters it was
+// taken against, which base_checksum identifies, and checksum identifies the parameters it leaves behind.
+const char kModelDeltaMagic[8] = {'N', 'P', 'L', 'X', 'D', 'L', 'T', 'A'};
+const uint32_t kModelDeltaVersion = 2;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t header_size;
+  int32_t n_input;
+  int32_t n_hidden;
+  int32_t n_output;
+  // Epoch and normalization of the network the delta was taken from, which applying the delta sets.
+  int32_t normalization;
+  int32_t epoch;
+  float max_float_training;
+  float min_float_training;
+  // Largest change left out of the delta, 0 for a delta that kept every parameter whose bits changed.
+  float tolerance;
+  uint64_t base_checksum;
+  uint64_t checksum;
+  uint64_t n_changes;
+} model_delta_header_t;
+
+// A checkpoint file holds everything training needs to carry on exactly where it left off: a
+// model_checkpoint_header_t, the parameters of the hidden then the output layer, then each field of the optimizer's
+// learning state in the order of Optimizer::learning_state_t, each for the hidden then the output layer, then the
+// n_input input scales and the n_input input offsets. Every array of a layer is in the layer's storage order and
+// each array follows the last with no padding.
+const char kModelCheckpointMagic[8] = {'N', 'P', 'L', 'X', 'C', 'K', 'P', 'T'};
+const uint32_t kModelCheckpointVersion = 2;
+const int kModelCheckpointStateFields = 7;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t header_size;
+  int32_t n_input;
+  int32_t n_hidden;
+  int32_t n_output;
+  int32_t activation;
+  int32_t normalization;
+  int32_t epoch;
+  // How the network was being trained: one of LearningAlgorithms, the number of workers sharing each epoch and the
+  // number of training rows.
+  int32_t learning_algo;
+  int32_t n_threads;
+  int32_t batch_size;
+  float max_float_training;
+  float min_float_training;
+  // Mean squared error of the last epoch.
+  float mse;
+} model_checkpoint_header_t;
+
+// A dataset file holds a dataset_file_header_t followed, from data_offset, by n_rows records of row_stride bytes,
+// each the features of a row then, labels_offset bytes into the record, its labels, every column in its type as a
+// Dataset stores it. Records are padded so that every value in them is aligned to its size. The file is read through
+// a mapping, see MappedDataset, so training reads it in place however large it is.
+const char kDatasetFileMagic[8] = {'N', 'P', 'L', 'X', 'D', 'A', 'T', 'A'};
+const uint32_t kDatasetFileVersion = 1;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t header_size;
+  // One of ColumnTypes and the number of columns of the features and of the labels.
+  int32_t features_type;
+  int32_t n_features;
+  int32_t labels_type;
+  int32_t n_labels;
+  uint64_t labels_offset;
+  uint64_t row_stride;
+  uint64_t data_offset;
+  uint64_t n_rows;
+} dataset_file_header_t;
+
+}  //namespace neuralplex
+#endif /*MODEL_FILE_H_*/
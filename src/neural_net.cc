@@ -31,136 +31,1152 @@
 #include <cmath>
 #include <fstream>
 #include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <exception>
 #include <random>
 #include <climits>
 #include <cfloat>
+#include <algorithm>
+#include <functional>
 #include "neural_net.h"
 #include "neural_net_constants.h"
+#include "neural_net_exceptions.h"
+#include "worker_pool.h"
+#include "rapidjson/filereadstream.h"
 #include "rapidjson/filestream.h"
+#include "rapidjson/filewritestream.h"
+#include "rapidjson/reader.h"
 
 namespace neuralplex {
 
-NeuralNet::NeuralNet (int n_input, int n_hidden, int n_output, float (*activation)(float), float (*activation_p)(float)) {
+// Name of the bias feeding the output layer, which tells it apart from the hidden layer's when reading JSON.
+static const char kOutputBiasName[] = "b0";
+
+NeuralNet::NeuralNet (int n_input, int n_hidden, int n_output, float (*activation)(float), float (*activation_p)(float))
+    : NeuralNet(n_input, n_hidden, n_output, new FunctionActivation(activation, activation_p)) { }
+
+NeuralNet::NeuralNet (int n_input, int n_hidden, int n_output, float (*activation)(float), float (*activation_p)(float), float *start_weights)
+    : NeuralNet(n_input, n_hidden, n_output, new FunctionActivation(activation, activation_p), start_weights) { }
+
+NeuralNet::NeuralNet (int n_input, int n_hidden, int n_output, Activation *activation, float *start_weights) {
   try {
     n_input_ = n_input;
     n_hidden_ = n_hidden;
     n_output_ = n_output;
-    static std::random_device rd;
-    static std::mt19937_64 mt(rd());
-    static std::uniform_real_distribution<float> distribution(-1.0/sqrt(n_input), 1.0/sqrt(n_input));
-    int n_weights = n_output + (n_output * n_hidden) + (n_input * n_hidden) + n_hidden;
-    float start_weights[n_weights];
-    for(int x = 0; x < n_weights; x++) start_weights[x] = distribution(mt);
-    BuildNetwork(activation, activation_p, &start_weights[0]);
+    activation_ = activation;
+    arena_ = learning_arena_ = NULL;
+    optimizer_ = NULL;
+    training_.learning_algo = kLearningAlgorithmsUndefined;
+    training_.n_threads = 1;
+    training_.batch_size = 0;
+    training_.mse = 1.0f;
+    mapping_ = NULL;
+    mapping_size_ = 0;
+    input_layer_ = hidden_layer_ = output_layer_ = NULL;
+    epoch_ = 0;
     max_float_training_ = 0.0f;
+    min_float_training_ = 0.0f;
+    normalization_ = kNormalizationRange;
+    input_scale_ = input_offset_ = NULL;
+    BuildNetwork(start_weights);
+    if (!start_weights) {
+      std::random_device rd;
+      RandomizeWeights(((uint64_t)rd() << 32) ^ rd());
+    }
   } catch (std::exception& e) {
     std::cerr << e.what() << std::endl;
   }
 }
 
-NeuralNet::NeuralNet (int n_input, int n_hidden, int n_output, float (*activation)(float), float (*activation_p)(float), float *start_weights) {
+NeuralNet::NeuralNet (const model_file_header_t &header, void *mapping, size_t mapping_size, Activation *activation) {
   try {
-    n_input_ = n_input;
-    n_hidden_ = n_hidden;
-    n_output_ = n_output;
-    BuildNetwork(activation, activation_p, start_weights);
+    n_input_ = header.n_input;
+    n_hidden_ = header.n_hidden;
+    n_output_ = header.n_output;
+    activation_ = activation;
+    arena_ = learning_arena_ = NULL;
+    optimizer_ = NULL;
+    training_.learning_algo = kLearningAlgorithmsUndefined;
+    training_.n_threads = 1;
+    training_.batch_size = 0;
+    training_.mse = 1.0f;
+    mapping_ = mapping;
+    mapping_size_ = mapping_size;
+    input_layer_ = hidden_layer_ = output_layer_ = NULL;
+    epoch_ = header.epoch;
+    max_float_training_ = header.max_float_training;
+    min_float_training_ = header.min_float_training;
+    normalization_ = header.normalization;
+    input_scale_ = input_offset_ = NULL;
+    if (!mapping) {
+      BuildNetwork(NULL);
+      return;
+    }
+    char *base = static_cast<char*>(mapping);
+    BuildNetwork(NULL, reinterpret_cast<float*>(base + header.hidden_params_offset),
+                 reinterpret_cast<float*>(base + header.output_params_offset),
+                 reinterpret_cast<float*>(base + header.normalization_offset));
   } catch (std::exception& e) {
     std::cerr << e.what() << std::endl;
   }
 }
 
-NeuralNet::~NeuralNet() { }
+// Neurons and every array of the layers live in the arena and go with it, only the layers' names need destroying.
+NeuralNet::~NeuralNet() {
+  if (output_layer_) output_layer_->~Layer();
+  if (hidden_layer_) hidden_layer_->~Layer();
+  if (input_layer_) input_layer_->~Layer();
+  delete optimizer_;
+  delete arena_;
+  delete learning_arena_;
+  if (mapping_) munmap(mapping_, mapping_size_);
+  delete activation_;
+}
+
+float NeuralNet::Train(const float training_data[], int batch_size, int learning_algo, int n_threads,
+                      Checkpointer *checkpointer) {
+  return Train(PackedDataset(training_data, batch_size), learning_algo, n_threads, checkpointer);
+}
 
-float NeuralNet::Train(float training_data[], int batch_size, int learning_algo) {
-  float mse = 1.0f;
+float NeuralNet::Train(const Dataset& dataset, int learning_algo, int n_threads, Checkpointer *checkpointer) {
+  if (dataset.features().n_cols != n_input_ || dataset.labels().n_cols != n_output_)
+    throw TrainingException("dataset of " + std::to_string(dataset.features().n_cols) + " features and " +
+                            std::to_string(dataset.labels().n_cols) + " labels given to a network of " +
+                            std::to_string(n_input_) + " inputs and " + std::to_string(n_output_) + " outputs");
+  if (dataset.n_rows() > INT_MAX) throw TrainingException("more than " + std::to_string(INT_MAX) + " rows");
+  InitLearningState();
   epoch_ = 0;
-  max_float_training_ = FLT_MIN;
-  min_float_training_ = FLT_MAX;
-  for (int row = 0; row < batch_size * (n_input_+n_output_); row += (n_input_ + n_output_)) {
-    for (int x = 0; x < n_input_; x++) {
-      if (training_data[row+x] > max_float_training_) {
-//        std::cout << training_data[row+x] << std::endl;
-          max_float_training_ = training_data[row+x];
+  ComputeNormalization(dataset, n_threads);
+  training_.learning_algo = learning_algo;
+  training_.n_threads = n_threads;
+  training_.batch_size = dataset.n_rows();
+  training_.mse = 1.0f;
+  return TrainEpochs(dataset, checkpointer);
+}
+
+float NeuralNet::Resume(const float training_data[], int batch_size, Checkpointer *checkpointer) {
+  return Resume(PackedDataset(training_data, batch_size), checkpointer);
+}
+
+float NeuralNet::Resume(const Dataset& dataset, Checkpointer *checkpointer) {
+  if (training_.batch_size == 0) throw TrainingException("no training to resume");
+  if (dataset.n_rows() != training_.batch_size)
+    throw TrainingException(std::to_string(dataset.n_rows()) + " rows given to resume training on " +
+                            std::to_string(training_.batch_size));
+  if (dataset.features().n_cols != n_input_ || dataset.labels().n_cols != n_output_)
+    throw TrainingException("dataset does not match the network's inputs and outputs");
+  return TrainEpochs(dataset, checkpointer);
 }
-      if (training_data[row+x] < min_float_training_) min_float_training_ = training_data[row+x];
+
+Dataset NeuralNet::PackedDataset(const float* training_data, int batch_size) const {
+  long row_stride = (n_input_ + n_output_) * sizeof(float);
+  return Dataset(batch_size, Dataset::Columns(training_data, kColumnFloat32, n_input_, row_stride),
+                 Dataset::Columns(training_data + n_input_, kColumnFloat32, n_output_, row_stride));
+}
+
+Dataset NeuralNet::InputsDataset(const float* inputs, size_t n_rows, size_t input_stride) const {
+  return Dataset(n_rows, Dataset::Columns(inputs, kColumnFloat32, n_input_, input_stride * sizeof(float)));
+}
+
+float NeuralNet::TrainEpochs(const Dataset& dataset, Checkpointer *checkpointer) {
+  int batch_size = training_.batch_size;
+  int learning_algo = training_.learning_algo;
+  float mse = training_.mse;
+  WorkerPool pool(training_.n_threads);
+  int n_workers = pool.n_workers();
+  training_.n_threads = n_workers;
+  size_t scratch_size = 0;
+  for (size_t x = 0; x < plan_.size(); x++) scratch_size += n_workers * plan_[x]->WorkspaceArenaSize(kTrainBatchRows);
+  Arena scratch(scratch_size);
+  // Every worker trains on a private set of workspaces holding a tile of kTrainBatchRows rows. The gradients of
+  // the private sets are added into the layers' in worker order before learning, so the summed gradients, and with
+  // them the RPROP sign decisions, are the same from run to run.
+  std::vector< std::vector<Layer::workspace_t> > private_workspaces(n_workers, std::vector<Layer::workspace_t>(plan_.size()));
+  std::vector< std::vector<Layer::workspace_t*> > workspaces(n_workers);
+  for (int worker = 0; worker < n_workers; worker++) {
+    for (size_t x = 0; x < plan_.size(); x++) {
+      plan_[x]->InitWorkspace(&private_workspaces[worker][x], kTrainBatchRows, &scratch);
+      workspaces[worker].push_back(&private_workspaces[worker][x]);
     }
   }
-  //std::cout << "MAX1 " << min_float_training_ << std::endl;
-
-  NormalizeInputs(&training_data[0], batch_size);
+  std::vector<float> worker_mse(n_workers);
+  // Each worker reads its shard a chunk at a time and its gradient sums run on across chunks, so an epoch still
+  // learns from the gradients of the whole batch and the tiles are those of a single pass over the shard.
+  std::function<void(int)> train_shard = [&](int worker) {
+    long begin, end;
+    pool.Shard(batch_size, worker, &begin, &end);
+    worker_mse[worker] = 0.0f;
+    dataset.ForEachChunk(begin, end, [&](long chunk_begin, long chunk_end) {
+      worker_mse[worker] = TrainRows(dataset, chunk_begin, chunk_end, &workspaces[worker][0], worker_mse[worker]);
+    });
+  };
   while (mse > kNeuralLearningThreshold && epoch_ < kNeuralLearningMaxEpoch) {
+    pool.Run(train_shard);
     mse = 0.0f;
-    for(int row = 0; row < batch_size*(n_input_+n_output_); row += (n_input_ + n_output_)) {
-      sort( neurons_.begin(), neurons_.end(), ForwardPropagation() );
-      for(int x = 0; x < n_input_; x++) input_neurons_[x]->set_input(training_data[row+x]);
-      for(int x = 0; x < n_output_; x++) output_neurons_[x]->set_ideal(training_data[row+n_input_+x]);
-      for(std::vector<Neuron*>::iterator it = neurons_.begin(); it != neurons_.end(); ++it) (*it)->Forward();
-      sort( neurons_.begin(), neurons_.end(), BackPropagation() );
-      for(std::vector<Neuron*>::iterator it = neurons_.begin(); it != neurons_.end(); ++it) (*it)->Backward();
-      for(std::vector<Neuron*>::iterator it = output_neurons_.begin(); it != output_neurons_.end(); ++it) mse += pow((*it)->error(),2)/n_output_;
-    }
-    for(std::vector<Neuron*>::iterator it = neurons_.begin(); it != neurons_.end(); ++it) (*it)->Learn(learning_algo);
+    for (int worker = 0; worker < n_workers; worker++) {
+      mse += worker_mse[worker];
+      for (size_t x = 0; x < plan_.size(); x++) plan_[x]->AddGradients(workspaces[worker][x]);
+    }
+    for(std::vector<Layer*>::iterator it = plan_.begin(); it != plan_.end(); ++it) optimizer_->Learn(*it, learning_algo);
     mse /= batch_size;
     std::cout << epoch_ << " " << "MSE: " << mse << std::endl;
     epoch_++;
+    training_.mse = mse;
+    if (checkpointer && epoch_ % checkpointer->interval() == 0) TakeCheckpoint(checkpointer);
+  }
+  if (checkpointer && epoch_ % checkpointer->interval() != 0) TakeCheckpoint(checkpointer);
+  // Leave the network holding the last training row, as it did when rows went through one at a time.
+  for (int worker = 0; worker < n_workers && epoch_ > 0; worker++) {
+    long begin, end;
+    pool.Shard(batch_size, worker, &begin, &end);
+    if (end > begin && end == batch_size) {
+      for (size_t x = 0; x < plan_.size(); x++) plan_[x]->KeepRow(*workspaces[worker][x], (end - begin - 1) % kTrainBatchRows);
+    }
   }
   return mse;
 }
 
-void NeuralNet::Compute(float inputs[], float* outputs) {
+// Pushes rows [begin, end) of the dataset, normalized, forwards and backwards through the network a tile of
+// kTrainBatchRows rows at a time, using one tile workspace per layer of the plan, and returns the squared error of
+// the rows added to mse.
+float NeuralNet::TrainRows(const Dataset& dataset, long begin, long end, Layer::workspace_t** workspaces, float mse) {
+  int last = plan_.size() - 1;
+  for (long tile = begin; tile < end; tile += kTrainBatchRows) {
+    int n_rows = std::min<long>(kTrainBatchRows, end - tile);
+    for (int row = 0; row < n_rows; row++) {
+      NormalizeRow(dataset, tile + row, workspaces[0]->output + row * n_input_);
+      std::copy(workspaces[0]->output + row * n_input_, workspaces[0]->output + (row + 1) * n_input_,
+                workspaces[0]->summation + row * n_input_);
+      dataset.ReadLabels(tile + row, workspaces[last]->ideal + row * n_output_);
+    }
+    for (int x = 1; x <= last; x++) plan_[x]->Forward(*workspaces[x - 1], workspaces[x], n_rows);
+    for (int x = last; x > 0; x--) plan_[x]->Backward(*workspaces[x - 1], x < last ? workspaces[x + 1] : NULL, workspaces[x], n_rows);
+    for (int x = 0; x < n_rows * n_output_; x++) mse += pow(workspaces[last]->error[x],2)/n_output_;
+  }
+  return mse;
+}
+
+void NeuralNet::Compute(const float inputs[], float* outputs) {
   try {
-    NormalizeInputs(inputs, 1);
-    sort( neurons_.begin(), neurons_.end(), ForwardPropagation() );
-    for(int x = 0; x < n_input_; x++) {input_neurons_[x]->set_input(inputs[x]);}
-    for(std::vector<Neuron*>::iterator it = neurons_.begin(); it != neurons_.end(); ++it) (*it)->Forward();
+    Layer::workspace_t *input = input_layer_->workspace();
+    NormalizeRow(inputs, &input->output[0]);
+    std::copy(input->output, input->output + n_input_, input->summation);
+    Forward();
     for(int x = 0; x < n_output_; x++) outputs[x] = output_neurons_[x]->output();
   } catch (std::exception& e) {
     std::cerr << e.what() << std::endl;
   }
 }
 
-void NeuralNet::BuildNetwork(float (*activation)(float), float (*activation_p)(float), float *start_weights){
+void NeuralNet::ComputeBatch(const float* inputs, size_t n_rows, float* outputs, size_t input_stride, size_t output_stride) const {
+  std::vector< std::vector<float> > tiles;
   try {
-    Neuron *bias_neuron = new Neuron::Neuron("b0", activation, activation_p);
+    ComputeBatch(InputsDataset(inputs, n_rows, input_stride), outputs, output_stride, &tiles);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+void NeuralNet::ComputeBatch(const Dataset& dataset, float* outputs, size_t output_stride) const {
+  std::vector< std::vector<float> > tiles;
+  ComputeBatch(dataset, outputs, output_stride, &tiles);
+}
+
+void NeuralNet::ComputeBatch(const Dataset& dataset, float* outputs, size_t output_stride,
+                             std::vector< std::vector<float> >* tiles) const {
+  try {
+    if (dataset.features().n_cols != n_input_)
+      throw DatasetException(std::to_string(dataset.features().n_cols) + " features given to a network of " +
+                             std::to_string(n_input_) + " inputs");
+    size_t n_rows = dataset.n_rows();
+    if (output_stride == 0) output_stride = n_output_;
+    // One tile of activations per layer, the last layer writes straight into outputs.
+    size_t n_tile_rows = std::min(n_rows, (size_t)kComputeBatchRows);
+    tiles->resize(plan_.size());
+    for (size_t x = 0; x + 1 < plan_.size(); x++) {
+      if ((*tiles)[x].size() < n_tile_rows * plan_[x]->n_neurons()) (*tiles)[x].resize(n_tile_rows * plan_[x]->n_neurons());
+    }
+    for (size_t row = 0; row < n_rows; row += n_tile_rows) {
+      int n = std::min(n_rows - row, n_tile_rows);
+      for (int x = 0; x < n; x++) NormalizeRow(dataset, row + x, &(*tiles)[0][x * n_input_]);
+      for (size_t x = 1; x < plan_.size(); x++) {
+        bool is_last = x + 1 == plan_.size();
+        float *out = is_last ? outputs + row * output_stride : &(*tiles)[x][0];
+        long ld_out = is_last ? output_stride : plan_[x]->n_neurons();
+        plan_[x]->ForwardBatch(&(*tiles)[x - 1][0], plan_[x - 1]->n_neurons(), out, ld_out, n);
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+// start_weights are read in the order the network has always been wired: the output bias, then for each hidden
+// neuron its bias followed by its weights to every output neuron, then for each input neuron its weights to every
+// hidden neuron.
+void NeuralNet::BuildNetwork(float *start_weights, float *hidden_params, float *output_params, float *normalization){
+  try {
+    // The layers, all their arrays and the neurons are sized up front so the whole network is one allocation.
+    int n_neurons = n_input_ + n_hidden_ + n_output_ + 2;
+    arena_ = new Arena(3 * Arena::Aligned(sizeof(Layer)) + Layer::ArenaSize(n_input_, 0) +
+                       Layer::ArenaSize(n_hidden_, n_input_, hidden_params == NULL) +
+                       Layer::ArenaSize(n_output_, n_hidden_, output_params == NULL) +
+                       Arena::Aligned(n_neurons * sizeof(Neuron)) +
+                       (normalization ? 0 : 2 * Arena::Aligned(n_input_ * sizeof(float))));
+    if (normalization) {
+      input_scale_ = normalization;
+      input_offset_ = normalization + n_input_;
+    } else {
+      input_scale_ = arena_->AllocateFloats(n_input_, 1.0f);
+      input_offset_ = arena_->AllocateFloats(n_input_);
+    }
+    input_layer_ = arena_->New<Layer>("i", "", 0, n_input_, (Layer*)NULL, activation_, arena_);
+    hidden_layer_ = arena_->New<Layer>("h", "b1", 1, n_hidden_, input_layer_, activation_, arena_, hidden_params);
+    output_layer_ = arena_->New<Layer>("o", kOutputBiasName, 2, n_output_, hidden_layer_, activation_, arena_,
+                                       output_params);
+    Neuron *neuron_storage = static_cast<Neuron*>(arena_->Allocate(n_neurons * sizeof(Neuron)));
+    neurons_.reserve(n_neurons);
+    input_neurons_.reserve(n_input_);
+    hidden_neurons_.reserve(n_hidden_);
+    output_neurons_.reserve(n_output_);
+    bias_neurons_.reserve(2);
+    Neuron *bias_neuron = new (neuron_storage++) Neuron(output_layer_, Neuron::kBiasIdx);
     neurons_.push_back(bias_neuron);
-    bias_neuron->set_input(1.0f);
     bias_neurons_.push_back(bias_neuron);
     for (int i=0; i < n_output_; i++) {
-      Neuron *output_neuron = new Neuron::Neuron("o"+std::to_string(i), activation, activation_p);
+      Neuron *output_neuron = new (neuron_storage++) Neuron(output_layer_, i);
       neurons_.push_back(output_neuron);
-      bias_neuron->ConnectTo(output_neuron, *start_weights++); 
+      if (start_weights) output_layer_->set_bias(i, *start_weights++);
       output_neurons_.push_back(output_neuron);
     }
-    bias_neuron = new Neuron::Neuron("b1", activation, activation_p);
+    bias_neuron = new (neuron_storage++) Neuron(hidden_layer_, Neuron::kBiasIdx);
     neurons_.push_back(bias_neuron);
     bias_neurons_.push_back(bias_neuron);
-    bias_neuron->set_input(1.0f);
     for (int i=0; i < n_hidden_;i++) {
-      Neuron *hidden_neuron = new Neuron::Neuron("h"+std::to_string(i), activation, activation_p);
+      Neuron *hidden_neuron = new (neuron_storage++) Neuron(hidden_layer_, i);
       neurons_.push_back(hidden_neuron);
-      bias_neuron->ConnectTo(hidden_neuron, *start_weights++); 
+      if (start_weights) hidden_layer_->set_bias(i, *start_weights++);
       hidden_neurons_.push_back(hidden_neuron);
-      for (int x = 0; x < output_neurons_.size(); x++) hidden_neuron->ConnectTo(output_neurons_[x], *start_weights++); 
+      if (start_weights) for (int x = 0; x < n_output_; x++) output_layer_->set_weight(x, i, *start_weights++);
     }
     for (int i=0; i < n_input_; i++){
-      Neuron *input_neuron = new Neuron::Neuron("i"+std::to_string(i), activation, activation_p);
+      Neuron *input_neuron = new (neuron_storage++) Neuron(input_layer_, i);
       neurons_.push_back(input_neuron);
-      for(int x = 0; x < hidden_neurons_.size(); x++) input_neuron->ConnectTo(hidden_neurons_[x], *start_weights++);  
+      if (start_weights) for(int x = 0; x < n_hidden_; x++) hidden_layer_->set_weight(x, i, *start_weights++);
       input_neurons_.push_back(input_neuron);
     }
+    CompilePlan();
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+void NeuralNet::InitLearningState() {
+  if (optimizer_) return;
+  if (!hidden_layer_->has_gradients() || !output_layer_->has_gradients()) {
+    learning_arena_ = new Arena(Arena::Aligned(hidden_layer_->n_params() * sizeof(float)) +
+                                Arena::Aligned(output_layer_->n_params() * sizeof(float)));
+    hidden_layer_->InitGradients(learning_arena_);
+    output_layer_->InitGradients(learning_arena_);
+  }
+  optimizer_ = new Optimizer(plan_);
+}
+
+// SplitMix64 finaliser, a bijective mix of a 64 bit counter into 64 well distributed bits.
+static inline uint64_t MixBits(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+void NeuralNet::RandomizeWeights(uint64_t seed, int n_threads) {
+  try {
+    Layer *layers[] = {hidden_layer_, output_layer_};
+    long first_block[3] = {0};
+    for (int l = 0; l < 2; l++)
+      first_block[l + 1] = first_block[l] + (layers[l]->n_params() + kInitBlockParams - 1) / kInitBlockParams;
+    long n_blocks = first_block[2];
+    if (n_threads <= 0) n_threads = std::thread::hardware_concurrency();
+    WorkerPool pool(std::max(1L, std::min((long)n_threads, n_blocks)));
+    float low = -1.0 / sqrt(n_input_);
+    float range = 2.0 / sqrt(n_input_);
+    pool.Run([&](int worker) {
+      long begin, end;
+      pool.Shard(n_blocks, worker, &begin, &end);
+      for (long block = begin; block < end; block++) {
+        int l = block < first_block[1] ? 0 : 1;
+        int offset = (block - first_block[l]) * kInitBlockParams;
+        // Successive values of the block's stream are its key plus multiples of the golden ratio, mixed.
+        uint64_t counter = MixBits(seed ^ MixBits(block + 1));
+        auto generator = [&]() {
+          counter += 0x9e3779b97f4a7c15ULL;
+          return low + range * ((MixBits(counter) >> 40) * (1.0f / (1 << 24)));
+        };
+        layers[l]->FillParams(offset, std::min(kInitBlockParams, layers[l]->n_params() - offset), generator);
+      }
+    });
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+bool NeuralNet::SetParams(int idx, const float *params, size_t count) {
+  try {
+    if (idx < 1 || idx >= n_layers()) throw ParamsException("no layer with parameters at " + std::to_string(idx));
+    if (count != (size_t)n_params(idx))
+      throw ParamsException(std::to_string(count) + " values given for " + std::to_string(n_params(idx)) + " parameters");
+    plan_[idx]->SetParams(params);
+    return true;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+// Parameters are checksummed with FNV-1a over their bits, in the order a model file holds them, and the result mixed
+// with MixBits.
+static const uint64_t kParamsChecksumBasis = 0xcbf29ce484222325ULL;
+
+static inline uint64_t ChecksumParam(uint64_t checksum, float param) {
+  uint32_t bits;
+  memcpy(&bits, &param, sizeof(bits));
+  return (checksum ^ bits) * 0x100000001b3ULL;
+}
+
+// Pads file with zeros up to offset.
+static void PadModelFile(std::ofstream &file, uint64_t offset) {
+  static const char zeros[kModelFileAlignment] = {0};
+  file.write(zeros, offset - file.tellp());
+}
+
+bool NeuralNet::SaveModel(const char *path) const {
+  try {
+    model_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kModelFileMagic, sizeof(header.magic));
+    header.version = kModelFileVersion;
+    header.byte_order = kModelFileByteOrder;
+    header.header_size = sizeof(header);
+    header.n_input = n_input_;
+    header.n_hidden = n_hidden_;
+    header.n_output = n_output_;
+    header.activation = activation_->id();
+    header.normalization = normalization_;
+    header.epoch = epoch_;
+    header.max_float_training = max_float_training_;
+    header.min_float_training = min_float_training_;
+    uint64_t hidden_bytes = (uint64_t)hidden_layer_->n_params() * sizeof(float);
+    uint64_t output_bytes = (uint64_t)output_layer_->n_params() * sizeof(float);
+    uint64_t input_bytes = (uint64_t)n_input_ * sizeof(float);
+    header.hidden_params_offset = (sizeof(header) + kModelFileAlignment - 1) & ~(kModelFileAlignment - 1);
+    header.output_params_offset = (header.hidden_params_offset + hidden_bytes + kModelFileAlignment - 1) & ~(kModelFileAlignment - 1);
+    header.normalization_offset = (header.output_params_offset + output_bytes + kModelFileAlignment - 1) & ~(kModelFileAlignment - 1);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) throw ModelFileException(std::string("cannot create ") + path);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    PadModelFile(file, header.hidden_params_offset);
+    file.write(reinterpret_cast<const char*>(hidden_layer_->params()), hidden_bytes);
+    PadModelFile(file, header.output_params_offset);
+    file.write(reinterpret_cast<const char*>(output_layer_->params()), output_bytes);
+    PadModelFile(file, header.normalization_offset);
+    file.write(reinterpret_cast<const char*>(input_scale_), input_bytes);
+    file.write(reinterpret_cast<const char*>(input_offset_), input_bytes);
+    file.close();
+    if (!file) throw ModelFileException(std::string("cannot write ") + path);
+    return true;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+// Parameters are compared against base and their bits written as they are, so a tolerance of 0 catches a change
+// from 0.0 to -0.0 as well as any other.
+bool NeuralNet::SaveDelta(const char *path, const NeuralNet &base, float tolerance) const {
+  try {
+    if (base.n_input_ != n_input_ || base.n_hidden_ != n_hidden_ || base.n_output_ != n_output_)
+      throw ModelFileException("delta base has another topology");
+    model_delta_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kModelDeltaMagic, sizeof(header.magic));
+    header.version = kModelDeltaVersion;
+    header.byte_order = kModelFileByteOrder;
+    header.header_size = sizeof(header);
+    header.n_input = n_input_;
+    header.n_hidden = n_hidden_;
+    header.n_output = n_output_;
+    header.normalization = normalization_;
+    header.epoch = epoch_;
+    header.max_float_training = max_float_training_;
+    header.min_float_training = min_float_training_;
+    header.tolerance = tolerance;
+    std::vector<uint32_t> indices;
+    std::vector<float> values;
+    const Layer *layers[] = {hidden_layer_, output_layer_};
+    const Layer *base_layers[] = {base.hidden_layer_, base.output_layer_};
+    uint32_t first = 0;
+    header.base_checksum = header.checksum = kParamsChecksumBasis;
+    for (int l = 0; l < 2; l++) {
+      const float *params = layers[l]->params();
+      const float *base_params = base_layers[l]->params();
+      for (int x = 0; x < layers[l]->n_params(); x++) {
+        bool changed = tolerance > 0.0f ? !(std::fabs(params[x] - base_params[x]) <= tolerance)
+                                        : memcmp(&params[x], &base_params[x], sizeof(float)) != 0;
+        header.base_checksum = ChecksumParam(header.base_checksum, base_params[x]);
+        header.checksum = ChecksumParam(header.checksum, changed ? params[x] : base_params[x]);
+        if (!changed) continue;
+        indices.push_back(first + x);
+        values.push_back(params[x]);
+      }
+      first += layers[l]->n_params();
+    }
+    header.base_checksum = MixBits(header.base_checksum);
+    header.checksum = MixBits(header.checksum);
+    header.n_changes = indices.size();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) throw ModelFileException(std::string("cannot create ") + path);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+    file.write(reinterpret_cast<const char*>(input_scale_), n_input_ * sizeof(float));
+    file.write(reinterpret_cast<const char*>(input_offset_), n_input_ * sizeof(float));
+    file.close();
+    if (!file) throw ModelFileException(std::string("cannot write ") + path);
+    return true;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+// The whole delta is read and checked, the parameters it leaves behind included, before the first one is written.
+bool NeuralNet::ApplyDelta(const char *path) {
+  try {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw ModelFileException(std::string("cannot open ") + path);
+    model_delta_header_t header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) throw ModelFileException("truncated");
+    if (memcmp(header.magic, kModelDeltaMagic, sizeof(header.magic)) != 0) throw ModelFileException("not a model delta");
+    if (header.byte_order != kModelFileByteOrder) throw ModelFileException("written with another byte order");
+    if (header.version != kModelDeltaVersion || header.header_size != sizeof(header))
+      throw ModelFileException("unsupported version " + std::to_string(header.version));
+    if (header.n_input != n_input_ || header.n_hidden != n_hidden_ || header.n_output != n_output_)
+      throw ModelFileException("delta for another topology");
+    uint64_t n_params = (uint64_t)hidden_layer_->n_params() + output_layer_->n_params();
+    if (header.n_changes > n_params) throw ModelFileException("truncated");
+    std::vector<uint32_t> indices(header.n_changes);
+    std::vector<float> values(header.n_changes);
+    std::vector<float> normalization(2 * n_input_);
+    file.read(reinterpret_cast<char*>(indices.data()), indices.size() * sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(float));
+    file.read(reinterpret_cast<char*>(normalization.data()), normalization.size() * sizeof(float));
+    if (!file) throw ModelFileException("truncated");
+    for (size_t i = 0; i < indices.size(); i++) {
+      if (indices[i] >= n_params || (i > 0 && indices[i] <= indices[i - 1])) throw ModelFileException("bad index");
+    }
+    Layer *layers[] = {hidden_layer_, output_layer_};
+    uint64_t base_checksum = kParamsChecksumBasis;
+    uint64_t checksum = kParamsChecksumBasis;
+    size_t next = 0;
+    uint32_t first = 0;
+    for (int l = 0; l < 2; l++) {
+      const float *params = layers[l]->params();
+      for (int x = 0; x < layers[l]->n_params(); x++) {
+        bool changed = next < indices.size() && indices[next] == first + x;
+        base_checksum = ChecksumParam(base_checksum, params[x]);
+        checksum = ChecksumParam(checksum, changed ? values[next++] : params[x]);
+      }
+      first += layers[l]->n_params();
+    }
+    if (MixBits(base_checksum) != header.base_checksum) throw ModelFileException("delta taken against other parameters");
+    if (MixBits(checksum) != header.checksum) throw ModelFileException("corrupt");
+    first = 0;
+    next = 0;
+    for (int l = 0; l < 2; l++) {
+      float *params = layers[l]->mutable_params();
+      uint32_t end = first + layers[l]->n_params();
+      for (; next < indices.size() && indices[next] < end; next++) params[indices[next] - first] = values[next];
+      first = end;
+    }
+    std::copy(normalization.begin(), normalization.begin() + n_input_, input_scale_);
+    std::copy(normalization.begin() + n_input_, normalization.end(), input_offset_);
+    normalization_ = header.normalization;
+    epoch_ = header.epoch;
+    max_float_training_ = header.max_float_training;
+    min_float_training_ = header.min_float_training;
+    return true;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+// Fields of the optimizer's learning state in the order a checkpoint file holds them.
+static float* Optimizer::learning_state_t::* const kCheckpointStateFields[kModelCheckpointStateFields] = {
+  &Optimizer::learning_state_t::last_delta,
+  &Optimizer::learning_state_t::last_gradient_batch_sum,
+  &Optimizer::learning_state_t::update_val,
+  &Optimizer::learning_state_t::last_update_val,
+  &Optimizer::learning_state_t::next_step,
+  &Optimizer::learning_state_t::weight_delta,
+  &Optimizer::learning_state_t::last_weight_delta
+};
+
+// The copy is the only part of a checkpoint training waits for.
+void NeuralNet::TakeCheckpoint(Checkpointer *checkpointer) const {
+  model_checkpoint_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kModelCheckpointMagic, sizeof(header.magic));
+  header.version = kModelCheckpointVersion;
+  header.byte_order = kModelFileByteOrder;
+  header.header_size = sizeof(header);
+  header.n_input = n_input_;
+  header.n_hidden = n_hidden_;
+  header.n_output = n_output_;
+  header.activation = activation_->id();
+  header.normalization = normalization_;
+  header.epoch = epoch_;
+  header.learning_algo = training_.learning_algo;
+  header.n_threads = training_.n_threads;
+  header.batch_size = training_.batch_size;
+  header.max_float_training = max_float_training_;
+  header.min_float_training = min_float_training_;
+  header.mse = training_.mse;
+  const Layer *layers[] = {hidden_layer_, output_layer_};
+  size_t n_params = hidden_layer_->n_params() + output_layer_->n_params();
+  std::vector<char> *buffer = checkpointer->Begin();
+  buffer->resize(sizeof(header) + ((1 + kModelCheckpointStateFields) * n_params + 2 * n_input_) * sizeof(float));
+  char *out = buffer->data();
+  memcpy(out, &header, sizeof(header));
+  out += sizeof(header);
+  for (int l = 0; l < 2; l++) {
+    memcpy(out, layers[l]->params(), layers[l]->n_params() * sizeof(float));
+    out += layers[l]->n_params() * sizeof(float);
+  }
+  for (int field = 0; field < kModelCheckpointStateFields; field++) {
+    for (int l = 0; l < 2; l++) {
+      memcpy(out, optimizer_->state(layers[l]).*kCheckpointStateFields[field], layers[l]->n_params() * sizeof(float));
+      out += layers[l]->n_params() * sizeof(float);
+    }
+  }
+  memcpy(out, input_scale_, n_input_ * sizeof(float));
+  memcpy(out + n_input_ * sizeof(float), input_offset_, n_input_ * sizeof(float));
+  checkpointer->Commit();
+}
+
+bool NeuralNet::LoadCheckpoint(const char *path) {
+  try {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw ModelFileException(std::string("cannot open ") + path);
+    model_checkpoint_header_t header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) throw ModelFileException("truncated");
+    if (memcmp(header.magic, kModelCheckpointMagic, sizeof(header.magic)) != 0)
+      throw ModelFileException("not a checkpoint");
+    if (header.byte_order != kModelFileByteOrder) throw ModelFileException("written with another byte order");
+    if (header.version != kModelCheckpointVersion || header.header_size != sizeof(header))
+      throw ModelFileException("unsupported version " + std::to_string(header.version));
+    if (header.n_input != n_input_ || header.n_hidden != n_hidden_ || header.n_output != n_output_)
+      throw ModelFileException("checkpoint of another topology");
+    if (header.activation != activation_->id()) throw ModelFileException("checkpoint of another activation");
+    if (header.batch_size <= 0 || header.n_threads <= 0) throw ModelFileException("bad training state");
+    size_t n_params = hidden_layer_->n_params() + output_layer_->n_params();
+    std::vector<float> values((1 + kModelCheckpointStateFields) * n_params + 2 * n_input_);
+    if (!file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(float)) || file.peek() != EOF)
+      throw ModelFileException("truncated");
+    InitLearningState();
+    Layer *layers[] = {hidden_layer_, output_layer_};
+    const float *in = values.data();
+    for (int l = 0; l < 2; l++) {
+      layers[l]->SetParams(in);
+      in += layers[l]->n_params();
+    }
+    for (int field = 0; field < kModelCheckpointStateFields; field++) {
+      for (int l = 0; l < 2; l++) {
+        std::copy(in, in + layers[l]->n_params(), optimizer_->state(layers[l]).*kCheckpointStateFields[field]);
+        in += layers[l]->n_params();
+      }
+    }
+    std::copy(in, in + n_input_, input_scale_);
+    std::copy(in + n_input_, in + 2 * n_input_, input_offset_);
+    normalization_ = header.normalization;
+    epoch_ = header.epoch;
+    max_float_training_ = header.max_float_training;
+    min_float_training_ = header.min_float_training;
+    training_.learning_algo = header.learning_algo;
+    training_.n_threads = header.n_threads;
+    training_.batch_size = header.batch_size;
+    training_.mse = header.mse;
+    return true;
   } catch (std::exception& e) {
     std::cerr << e.what() << std::endl;
+    return false;
   }
 }
 
-void NeuralNet::NormalizeInputs(float* training_data, int batch_size) {
- // std::cout << max_float_training_ << std::endl;
- //std::cout << "MAX2 " << min_float_training_ << std::endl;
+// Checks that header describes a model file of this version whose parameters lie within size bytes.
+static void CheckModelHeader(const model_file_header_t &header, size_t size) {
+  if (memcmp(header.magic, kModelFileMagic, sizeof(header.magic)) != 0) throw ModelFileException("not a model file");
+  if (header.byte_order != kModelFileByteOrder) throw ModelFileException("written with another byte order");
+  if (header.version != kModelFileVersion || header.header_size != sizeof(header))
+    throw ModelFileException("unsupported version " + std::to_string(header.version));
+  if (header.n_input <= 0 || header.n_hidden <= 0 || header.n_output <= 0) throw ModelFileException("bad topology");
+  uint64_t hidden_bytes = (uint64_t)header.n_hidden * (header.n_input + 1) * sizeof(float);
+  uint64_t output_bytes = (uint64_t)header.n_output * (header.n_hidden + 1) * sizeof(float);
+  uint64_t normalization_bytes = (uint64_t)2 * header.n_input * sizeof(float);
+  if (header.hidden_params_offset % kModelFileAlignment || header.output_params_offset % kModelFileAlignment ||
+      header.normalization_offset % kModelFileAlignment)
+    throw ModelFileException("misaligned parameters");
+  if (header.hidden_params_offset < sizeof(header) || header.hidden_params_offset + hidden_bytes > size ||
+      header.output_params_offset < sizeof(header) || header.output_params_offset + output_bytes > size ||
+      header.normalization_offset < sizeof(header) || header.normalization_offset + normalization_bytes > size)
+    throw ModelFileException("truncated");
+}
+
+NeuralNet* NeuralNet::MapModel(const char *path, Activation *activation) {
+  int fd = -1;
+  void *mapping = MAP_FAILED;
+  size_t size = 0;
+  try {
+    fd = open(path, O_RDONLY);
+    if (fd < 0) throw ModelFileException(std::string("cannot open ") + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) throw ModelFileException(std::string("cannot stat ") + path);
+    size = st.st_size;
+    if (size < sizeof(model_file_header_t)) throw ModelFileException("truncated");
+    // Writable so that training can still update the weights, private so that it never writes to the file.
+    mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) throw ModelFileException(std::string("cannot map ") + path);
+    close(fd);
+    fd = -1;
+    const model_file_header_t &header = *static_cast<const model_file_header_t*>(mapping);
+    CheckModelHeader(header, size);
+    if (!activation) activation = NewActivation(header.activation);
+    if (!activation) throw ModelFileException("no activation given for activation " + std::to_string(header.activation));
+    return new NeuralNet(header, mapping, size, activation);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    if (fd >= 0) close(fd);
+    if (mapping != MAP_FAILED) munmap(mapping, size);
+    delete activation;
+    return NULL;
+  }
+}
+
+// SAX handler reading a network back from the JSON NeuralNet::ToJSON writes. The topology is counted from the input
+// and bias neurons, which the writer puts ahead of the hidden and output neurons, and the network is built as soon
+// as the hidden neurons begin. Every weight and bias then goes straight into the layers as the parents of the hidden
+// and output neurons are read, each neuron's parents naming the weights feeding it. Weights listed as children and
+// the activations of the neurons are skipped. A file in the compact schema states its topology up front and the
+// network is built when its layers begin, each weight and bias going into place as the flat arrays are read. Keys
+// are matched once, as they are read, and only the names of parents are looked at, so the handler adds little to
+// the parser's own cost.
+class JSONModelReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JSONModelReader> {
+ public:
+  // activation: optional activation overriding the file's, owned by the reader until it builds the network.
+  explicit JSONModelReader(Activation *activation) {
+    activation_ = activation;
+    net_ = NULL;
+    layer_ = NULL;
+    header_ = model_file_header_t();
+    header_.activation = kActivationCustom;
+    depth_ = 0;
+    key_ = kKeyOther;
+    section_ = kKeyOther;
+    parents_ = false;
+    output_bias_ = false;
+    neuron_ = -1;
+    n_written_ = 0;
+    has_weight_ = false;
+    input_ = kNoInput;
+    param_ = param_end_ = 0;
+  }
+  virtual ~JSONModelReader() {
+    delete activation_;
+    delete net_;
+  }
+  bool Default() { return true; }
+  bool Int(int i) { return Double(i); }
+  bool Uint(unsigned u) { return Double(u); }
+  bool Int64(int64_t i) { return Double(i); }
+  bool Uint64(uint64_t u) { return Double(u); }
+  bool Double(double d) {
+    if (depth_ == 4 && section_ == kKeyLayers && layer_) {
+      if (param_ >= param_end_) return Fail("too many parameters in layer " + layer_->name());
+      int n_weights = layer_->n_neurons() * layer_->n_inputs();
+      if (param_ < n_weights) layer_->set_weight(param_ / layer_->n_inputs(), param_ % layer_->n_inputs(), d);
+      else layer_->set_bias(param_ - n_weights, d);
+      param_++;
+      n_written_++;
+    } else if (depth_ == 2 && (section_ == kKeyInputScale || section_ == kKeyInputOffset)) {
+      normalization_[section_ == kKeyInputScale ? 0 : 1].push_back(d);
+    } else if (depth_ == 5) {
+      if (key_ == kKeyWeight) {
+        weight_ = d;
+        has_weight_ = true;
+      }
+    } else if (depth_ == 1) {
+      if (key_ == kKeyActivation) header_.activation = d;
+      else if (key_ == kKeyEpoch) header_.epoch = d;
+      else if (key_ == kKeyNormalization) header_.normalization = d;
+      else if (key_ == kKeyMaxFloatTraining) header_.max_float_training = d;
+      else if (key_ == kKeyMinFloatTraining) header_.min_float_training = d;
+      else if (key_ == kKeyInputCount) header_.n_input = d;
+      else if (key_ == kKeyHiddenCount) header_.n_hidden = d;
+      else if (key_ == kKeyOutputCount) header_.n_output = d;
+    }
+    return true;
+  }
+  bool String(const char *str, rapidjson::SizeType length, bool copy) {
+    if (depth_ == 5 && key_ == kKeyNeuron && layer_ && parents_) {
+      input_ = FindInput(str, length);
+    } else if (depth_ == 3 && key_ == kKeyName && section_ == kKeyBiasNeurons) {
+      output_bias_ = length == sizeof(kOutputBiasName) - 1 && memcmp(str, kOutputBiasName, length) == 0;
+    }
+    return true;
+  }
+  bool Key(const char *str, rapidjson::SizeType length, bool copy) {
+    key_ = kKeyOther;
+    if (depth_ == 5 && !(layer_ && parents_)) return true;
+    for (int key = 0; key < kKeyOther; key++) {
+      if (strncmp(kKeys[key], str, length) == 0 && kKeys[key][length] == '\0') {
+        key_ = key;
+        break;
+      }
+    }
+    return true;
+  }
+  bool StartObject() {
+    depth_++;
+    if (depth_ == 3) {
+      neuron_++;
+      output_bias_ = false;
+      if (section_ == kKeyLayers) {
+        if (neuron_ > 1) return Fail("too many layers");
+        layer_ = neuron_ == 0 ? net_->hidden_layer_ : net_->output_layer_;
+      }
+    } else if (depth_ == 5) {
+      has_weight_ = false;
+      input_ = kNoInput;
+    }
+    return true;
+  }
+  bool EndObject(rapidjson::SizeType n_members) {
+    depth_--;
+    if (depth_ == 4 && layer_ && parents_) return WriteSynapse();
+    if (depth_ == 2 && section_ == kKeyLayers) layer_ = NULL;
+    return true;
+  }
+  bool StartArray() {
+    depth_++;
+    if (depth_ == 2) {
+      section_ = key_;
+      neuron_ = -1;
+      layer_ = NULL;
+      if (section_ == kKeyHiddenNeurons || section_ == kKeyOutputNeurons || section_ == kKeyLayers) {
+        if (!net_ && !Build()) return false;
+      }
+      if (section_ == kKeyHiddenNeurons) layer_ = net_->hidden_layer_;
+      if (section_ == kKeyOutputNeurons) layer_ = net_->output_layer_;
+    } else if (depth_ == 4) {
+      parents_ = key_ == kKeyParents;
+      if (section_ == kKeyLayers && layer_) {
+        int n_weights = layer_->n_neurons() * layer_->n_inputs();
+        param_ = key_ == kKeyBiases ? n_weights : 0;
+        param_end_ = key_ == kKeyBiases ? layer_->n_params() : key_ == kKeyWeights ? n_weights : 0;
+      }
+    }
+    return true;
+  }
+  bool EndArray(rapidjson::SizeType n_elements) {
+    depth_--;
+    if (depth_ == 1) {
+      if (section_ == kKeyInputNeurons) header_.n_input = n_elements;
+      if (layer_ && (int)n_elements != layer_->n_neurons()) return Fail(std::string(kKeys[section_]) + " missing");
+      if (section_ == kKeyLayers && n_elements != 2) return Fail("layers missing");
+      section_ = kKeyOther;
+      layer_ = NULL;
+    } else if (depth_ == 3 && section_ == kKeyLayers) {
+      if (layer_ && param_ != param_end_) return Fail("parameters missing in layer " + layer_->name());
+    } else if (depth_ == 3 && !parents_) {
+      // The children of an input neuron are the hidden neurons, those of a bias neuron the layer it feeds.
+      if (section_ == kKeyInputNeurons && neuron_ == 0) header_.n_hidden = n_elements;
+      if (section_ == kKeyBiasNeurons && output_bias_) header_.n_output = n_elements;
+    }
+    return true;
+  }
+  // Returns the network read, which the caller takes ownership of, throws ModelFileException if it is incomplete.
+  // Files written before networks kept a scale and offset per input are normalized from their bounds.
+  NeuralNet* Release() {
+    if (!net_) throw ModelFileException("no hidden or output neurons");
+    if (n_written_ != (long)net_->hidden_layer_->n_params() + net_->output_layer_->n_params())
+      throw ModelFileException("weights missing");
+    if (normalization_[0].empty() && normalization_[1].empty()) {
+      // Files written before the bounds of the training inputs were give neither them nor the scales and offsets,
+      // and there is no telling how their networks normalized their inputs.
+      if (!(net_->max_float_training_ > net_->min_float_training_)) throw ModelFileException("no input normalization");
+      net_->SetRangeNormalization();
+    } else {
+      for (int i = 0; i < 2; i++) {
+        if ((int)normalization_[i].size() != net_->n_input_)
+          throw ModelFileException("input scales or offsets missing");
+      }
+      std::copy(normalization_[0].begin(), normalization_[0].end(), net_->input_scale_);
+      std::copy(normalization_[1].begin(), normalization_[1].end(), net_->input_offset_);
+    }
+    NeuralNet *net = net_;
+    net_ = NULL;
+    return net;
+  }
+  const std::string& error() const { return error_; }
+
+ private:
+  // Keys the reader acts on, in the order of kKeys, kKeyOther standing for any other.
+  enum Keys {
+    kKeyActivation, kKeyEpoch, kKeyMaxFloatTraining, kKeyMinFloatTraining, kKeyInputNeurons, kKeyBiasNeurons,
+    kKeyHiddenNeurons, kKeyOutputNeurons, kKeyName, kKeyParents, kKeyWeight, kKeyNeuron, kKeyInputCount,
+    kKeyHiddenCount, kKeyOutputCount, kKeyLayers, kKeyWeights, kKeyBiases, kKeyNormalization, kKeyInputScale,
+    kKeyInputOffset, kKeyOther
+  };
+  static const char* const kKeys[kKeyOther];
+  // Values of input_ for a synapse from the bias and for one whose neuron has not been read or is unknown.
+  static const int kBiasInput = -1;
+  static const int kNoInput = -2;
+  bool Fail(const std::string& error) {
+    error_ = error;
+    return false;
+  }
+  bool Build() {
+    if (header_.n_input <= 0 || header_.n_hidden <= 0 || header_.n_output <= 0)
+      return Fail("input and bias neurons must come first");
+    if (!activation_) activation_ = NewActivation(header_.activation);
+    if (!activation_) return Fail("no activation given for activation " + std::to_string(header_.activation));
+    net_ = new NeuralNet(header_, NULL, 0, activation_);
+    activation_ = NULL;
+    return true;
+  }
+  // Returns the column of the current layer's weights fed by the neuron named str, kBiasInput for the bias.
+  int FindInput(const char *str, size_t length) const {
+    const std::string& bias = layer_->bias_name();
+    if (length == bias.size() && memcmp(str, bias.data(), length) == 0) return kBiasInput;
+    const std::string& below = layer_->below()->name();
+    if (length <= below.size() || memcmp(str, below.data(), below.size()) != 0) return kNoInput;
+    long x = 0;
+    for (size_t i = below.size(); i < length; i++) {
+      if (str[i] < '0' || str[i] > '9' || x >= layer_->n_inputs()) return kNoInput;
+      x = x * 10 + str[i] - '0';
+    }
+    return x < layer_->n_inputs() ? x : kNoInput;
+  }
+  // Writes the synapse just read into the parameter feeding the current neuron from the neuron it names.
+  bool WriteSynapse() {
+    if (!has_weight_ || input_ == kNoInput || neuron_ >= layer_->n_neurons())
+      return Fail("bad parent of " + layer_->neuron_name(neuron_));
+    if (input_ == kBiasInput) layer_->set_bias(neuron_, weight_);
+    else layer_->set_weight(neuron_, input_, weight_);
+    n_written_++;
+    return true;
+  }
+  Activation *activation_;
+  NeuralNet *net_;
+  // Layer whose neurons are being read, NULL outside the hidden and output neurons.
+  Layer *layer_;
+  // Topology, activation and normalization bounds as far as they have been read.
+  model_file_header_t header_;
+  // Nesting of the value being read, 1 inside the network object, 2 in a list of neurons, 3 in a neuron, 4 in its
+  // parents or children and 5 in a synapse. In the compact schema 2 is the list of layers, 3 a layer and 4 its
+  // weights or biases.
+  int depth_;
+  int key_;
+  // Key of the list of neurons being read.
+  int section_;
+  bool parents_;
+  bool output_bias_;
+  int neuron_;
+  long n_written_;
+  float weight_;
+  bool has_weight_;
+  int input_;
+  // Next parameter of layer_ a flat array of the compact schema fills and the end of that array.
+  int param_;
+  int param_end_;
+  // Input scales and input offsets as far as they have been read.
+  std::vector<float> normalization_[2];
+  std::string error_;
+};
+
+const char* const JSONModelReader::kKeys[kKeyOther] = {
+  "activation", "epoch", "maxFloatTraining", "minFloatTraining", "inputNeurons", "biasNeurons", "hiddenNeurons",
+  "outputNeurons", "name", "parents", "weight", "neuron", "inputCount", "hiddenCount", "outputCount", "layers",
+  "weights", "biases", "normalization", "inputScale", "inputOffset"
+};
+
+NeuralNet* NeuralNet::FromJSON(const char *path, Activation *activation) {
+  FILE *file = NULL;
+  try {
+    JSONModelReader model(activation);
+    file = fopen(path, "rb");
+    if (!file) throw ModelFileException(std::string("cannot open ") + path);
+    std::vector<char> buffer(kJSONReadBufferSize);
+    rapidjson::FileReadStream stream(file, &buffer[0], buffer.size());
+    rapidjson::Reader reader;
+    // Weights are written as the shortest double that reads back as the float, so the default precision suffices.
+    reader.Parse(stream, model);
+    fclose(file);
+    file = NULL;
+    if (reader.HasParseError()) {
+      if (!model.error().empty()) throw ModelFileException(model.error());
+      throw ModelFileException("JSON parse error at offset " + std::to_string(reader.GetErrorOffset()));
+    }
+    return model.Release();
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    if (file) fclose(file);
+    return NULL;
+  }
+}
+
+bool NeuralNet::WriteJSON(int fd, int schema, bool pretty) {
+  FILE *file = NULL;
+  try {
+    // The stream writes a duplicate of fd, so that closing it leaves fd open, unbuffered as the stream has a buffer.
+    int stream_fd = dup(fd);
+    if (stream_fd >= 0) file = fdopen(stream_fd, "w");
+    if (!file) {
+      if (stream_fd >= 0) close(stream_fd);
+      throw ModelFileException("cannot write to file descriptor " + std::to_string(fd));
+    }
+    setvbuf(file, NULL, _IONBF, 0);
+    write_buffer_.resize(kJSONWriteBufferSize);
+    rapidjson::FileWriteStream stream(file, &write_buffer_[0], write_buffer_.size());
+    if (pretty) {
+      rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(stream);
+      ToJSON(writer, schema);
+    } else {
+      rapidjson::Writer<rapidjson::FileWriteStream> writer(stream);
+      ToJSON(writer, schema);
+    }
+    stream.Flush();
+    bool failed = ferror(file) != 0;
+    failed = fclose(file) != 0 || failed;
+    file = NULL;
+    if (failed) throw ModelFileException("cannot write to file descriptor " + std::to_string(fd));
+    return true;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    if (file) fclose(file);
+    return false;
+  }
+}
+
+// The topology never changes once built, so neurons_ is put in forward order once and the layers are recorded in
+// that order rather than sorting the network for every row. Each step of the plan runs a whole layer so that its
+// weights are swept by a single kernel call.
+void NeuralNet::CompilePlan() {
+  stable_sort( neurons_.begin(), neurons_.end(), ForwardPropagation() );
+  plan_.clear();
+  plan_.reserve(3);
+  for (std::vector<Neuron*>::const_iterator it = neurons_.begin(); it != neurons_.end(); ++it) {
+    if (!(*it)->is_bias() && (plan_.empty() || plan_.back() != (*it)->layer())) plan_.push_back((*it)->layer());
+  }
+}
+
+void NeuralNet::Forward() {
+  for (std::vector<Layer*>::const_iterator it = plan_.begin(); it != plan_.end(); ++it) (*it)->Forward();
+}
+
+// Each worker gathers the statistics of its shard of rows, read a chunk at a time, which are merged in worker order.
+// Features stored as floats are read in place, others are widened a tile of kTrainBatchRows rows at a time into the
+// worker's scratch, which column_stats adds up in the same row order.
+void NeuralNet::ComputeNormalization(const Dataset& dataset, int n_threads) {
+  int batch_size = dataset.n_rows();
+  WorkerPool pool(std::max(1, std::min(n_threads <= 0 ? (int)std::thread::hardware_concurrency() : n_threads,
+                                       batch_size)));
+  int n_workers = pool.n_workers();
+  std::vector< std::vector<float> > min(n_workers, std::vector<float>(n_input_, FLT_MAX));
+  std::vector< std::vector<float> > max(n_workers, std::vector<float>(n_input_, -FLT_MAX));
+  std::vector< std::vector<double> > sum(n_workers, std::vector<double>(n_input_));
+  std::vector< std::vector<double> > sum_sq(n_workers, std::vector<double>(n_input_));
+  const kernels_t &kernels = Kernels();
+  pool.Run([&](int worker) {
+    long begin, end;
+    pool.Shard(batch_size, worker, &begin, &end);
+    long ldx = dataset.features().row_stride / (long)sizeof(float);
+    std::vector<float> tile(dataset.float_features(0) ? 0 : kTrainBatchRows * n_input_);
+    dataset.ForEachChunk(begin, end, [&](long chunk_begin, long chunk_end) {
+      if (dataset.float_features(chunk_begin)) {
+        kernels.column_stats(dataset.float_features(chunk_begin), chunk_end - chunk_begin, ldx, n_input_,
+                             &min[worker][0], &max[worker][0], &sum[worker][0], &sum_sq[worker][0]);
+        return;
+      }
+      for (long row = chunk_begin; row < chunk_end; row += kTrainBatchRows) {
+        int n_rows = std::min<long>(kTrainBatchRows, chunk_end - row);
+        for (int x = 0; x < n_rows; x++) dataset.ReadFeatures(row + x, &tile[x * n_input_]);
+        kernels.column_stats(&tile[0], n_rows, n_input_, n_input_, &min[worker][0], &max[worker][0],
+                             &sum[worker][0], &sum_sq[worker][0]);
+      }
+    });
+  });
+  for (int worker = 1; worker < n_workers; worker++) {
+    for (int x = 0; x < n_input_; x++) {
+      min[0][x] = std::min(min[0][x], min[worker][x]);
+      max[0][x] = std::max(max[0][x], max[worker][x]);
+      sum[0][x] += sum[worker][x];
+      sum_sq[0][x] += sum_sq[worker][x];
+    }
+  }
+  min_float_training_ = FLT_MAX;
+  max_float_training_ = -FLT_MAX;
+  for (int x = 0; x < n_input_; x++) {
+    min_float_training_ = std::min(min_float_training_, min[0][x]);
+    max_float_training_ = std::max(max_float_training_, max[0][x]);
+  }
+  switch (normalization_) {
+    case kNormalizationRange:
+      SetRangeNormalization();
+      break;
+    case kNormalizationFeatureRange:
+      for (int x = 0; x < n_input_; x++) {
+        float range = max[0][x] - min[0][x];
+        input_scale_[x] = range > 0.0f ? kNeuralInputRange / range : 1.0f;
+        input_offset_[x] = kNeuralInputLower - min[0][x] * input_scale_[x];
+      }
+      break;
+    case kNormalizationFeatureStandard:
+      for (int x = 0; x < n_input_; x++) {
+        double mean = sum[0][x] / batch_size;
+        double std_dev = sqrt(std::max(0.0, sum_sq[0][x] / batch_size - mean * mean));
+        input_scale_[x] = std_dev > 0.0 ? 1.0 / std_dev : 1.0;
+        input_offset_[x] = std_dev > 0.0 ? -mean / std_dev : -mean;
+      }
+      break;
+    default:
+      throw TrainingException("unknown normalization " + std::to_string(normalization_));
+  }
+}
+
+// The same arithmetic the inputs were always normalized with, so the scale and offset are bit for bit those terms.
+// Inputs that never varied are only shifted onto kNeuralInputLower.
+void NeuralNet::SetRangeNormalization() {
+  float range = max_float_training_ - min_float_training_;
+  float scale = range > 0.0f ? kNeuralInputRange / range : 1.0f;
+  float offset = kNeuralInputLower - min_float_training_ * scale;
+  std::fill(input_scale_, input_scale_ + n_input_, scale);
+  std::fill(input_offset_, input_offset_ + n_input_, offset);
+}
+
+void NeuralNet::NormalizeRow(const float* inputs, float* normalized) const {
+  for (int x = 0; x < n_input_; x++) normalized[x] = inputs[x] * input_scale_[x] + input_offset_[x];
+}
 
-  for (int row = 0; row < batch_size*(n_input_+n_output_); row += (n_input_+n_output_)) {
-    for (int x = 0; x < n_input_; x++) training_data[row+x] = (float)training_data[row+x] * ( kNeuralInputRange/(max_float_training_-min_float_training_)  ) + 
-      (kNeuralInputLower - (min_float_training_*(kNeuralInputRange / (max_float_training_-min_float_training_))));
+void NeuralNet::NormalizeRow(const Dataset& dataset, long row, float* normalized) const {
+  const float *inputs = dataset.float_features(row);
+  if (!inputs) {
+    dataset.ReadFeatures(row, normalized);
+    inputs = normalized;
   }
+  NormalizeRow(inputs, normalized);
 }
 } //namespace neuralplex
\ No newline at end of file
@@ -28,10 +28,17 @@
 #ifndef NEURAL_NET_H_
 #define NEURAL_NET_H_
 
+#include<stdint.h>
 #include<stdlib.h>
 #include<string>
 #include<vector>
-#include "Neuron.h"
+#include "checkpointer.h"
+#include "dataset.h"
+#include "layer.h"
+#include "model_file.h"
+#include "neural_net_constants.h"
+#include "neuron.h"
+#include "optimizer.h"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/stringbuffer.h"
 
@@ -41,7 +48,8 @@
 // that there is an input layer, a hidden layer and an output layer. There is no upper limit on the number of
 // neurons per level which are configured with n_input, n_hidden and n_output respectively. To use this class
 // just initialize with number neurons per layer, an activation function like sigmoid or tanh and the derivative  of
-// the activation function. You then call Train (once only) providing your training data set and neuralplex learns.
+// the activation function, or use BasicNeuralNet with one of the activation policies in activations.h. You then
+// call Train (once only) providing your training data set and neuralplex learns.
 // If convergence was achieved, which you can check by ensuring the global error return from calling Train is
 // smaller or equal to kNeuralLearningThreshold. If so, the compute method is now an approximation of
 // training data function. If convergence fails, you should try to tweak the number neurons, the training data,
@@ -70,36 +78,128 @@ class NeuralNet {
   // n_hidden: number of neurons in hidden layer
   // n_output: number of neurons in output layer 
   // activation: the activation function used for node delta calculation
-  // activation_p: the derivative of the activation function used for gradient decent
-  // start_weights: optional if you wish to provide your own random or pre-trained starting weight values.
+  // activation_p: the derivative of the activation function used for gradient decent, evaluated at the summation
+  //   of each neuron in every layer
+  // start_weights: optional if you wish to provide your own random or pre-trained starting weight values, without
+  //   them the weights are drawn by RandomizeWeights from a random seed.
   NeuralNet (int n_input, int n_hidden, int n_output, float (*activation)(float), float (*activation_p)(float));
   NeuralNet (int n_input, int n_hidden, int n_output, float (*activation)(float), float (*activation_p)(float), float *start_weights);
+  // activation: the activation and its derivative, the network takes ownership of it.
+  NeuralNet (int n_input, int n_hidden, int n_output, Activation *activation, float *start_weights = NULL);
   virtual ~NeuralNet();
+  // Draws every weight and bias uniformly from +/-1/sqrt(n_input), writing straight into the network. The weights are
+  // split into blocks of kInitBlockParams, each drawn from its own counter-based stream keyed on seed and the block
+  // index, so the same seed gives the same network whatever n_threads is.
+  // n_threads: number of threads sharing the blocks, 0 uses one thread per hardware thread.
+  void RandomizeWeights(uint64_t seed, int n_threads = 0);
+  // Writes the topology, activation, input normalization bounds and weights of the network to a model file at path,
+  // see model_file.h. Returns false if the file could not be written.
+  bool SaveModel(const char *path) const;
+  // Writes a model delta file at path that turns base, a network of the same topology, into this network, see
+  // model_file.h. Only parameters that differ from base by more than tolerance are stored, or with a tolerance of 0
+  // those whose bits differ, so applying the delta reproduces this network exactly. Returns false if base has another
+  // topology or the file could not be written.
+  bool SaveDelta(const char *path, const NeuralNet &base, float tolerance = 0.0f) const;
+  // Applies the model delta file at path to the network in place, rewriting the parameters it stores and taking the
+  // epoch and normalization bounds of the network it was taken from. Returns false, leaving the network untouched, if
+  // the file cannot be read or was taken against other parameters. No other thread may use the network meanwhile.
+  bool ApplyDelta(const char *path);
+  // Returns a network served straight from a mapping of the model file at path, or NULL if it cannot be mapped or is
+  // not a model file of this version. The weights are not copied: the mapping is private, so processes mapping the
+  // same file, e.g. workers forked after loading, share its pages until one of them trains and writes to them.
+  // Construction takes the same time whatever the size of the model.
+  // activation: optional activation to use in place of the one the file names, required for a network saved with
+  //   activation function pointers. The network takes ownership of it.
+  static NeuralNet* MapModel(const char *path, Activation *activation = NULL);
+  // Returns a network read from the JSON representation ToJSON or WriteJSON, in either schema, wrote to the file at
+  // path, or NULL if it cannot be read. The file is parsed as a stream of events, without building a document, and
+  // each weight is written into the network as it is read. A file giving neither the input scales and offsets nor
+  // the bounds of the training inputs, as none did before they were written, cannot be read, as nothing says how
+  // its network normalized its inputs.
+  // activation: optional activation to use in place of the one the file names, required for files that name none
+  //   or name kActivationCustom. The network takes ownership of it.
+  static NeuralNet* FromJSON(const char *path, Activation *activation = NULL);
+  // Finds how to normalize each input from the training rows, as set_normalization chose, in one pass shared by
+  // n_threads threads, then trains the network on them. The inputs are normalized as they are pushed through the
+  // network, the training data itself is not changed.
   // training_data: inputs followed by ideal outputs per row, rows are joined to form a 1d array of training_data.
   // batch_size: number of input+output pairs in training data
   // learning_algo: kLearningAlgorithmsResilientProp and kLearningAlgorithmsBackProp currently supported.
-  float Train(float training_data[], int batch_size,  int learning_algo);
-  // inputs: array of approximated functions inputs
+  // n_threads: number of threads sharing each epoch, the rows are split into that many contiguous shards and the
+  // gradients of the shards are summed in shard order, so results are reproducible for a given n_threads. 0 uses
+  // one thread per hardware thread.
+  // checkpointer: optional, takes a checkpoint of the training every checkpointer->interval() epochs and when
+  // training stops, see LoadCheckpoint. Taking one copies the training state and leaves writing it to the
+  // checkpointer's thread.
+  float Train(const float training_data[], int batch_size,  int learning_algo, int n_threads = 1,
+              Checkpointer *checkpointer = NULL);
+  // Same as above on the rows of dataset, whose features are the inputs and labels the ideal outputs, widened to
+  // float a tile of rows at a time as they are read. Each worker reads its shard a chunk at a time, see
+  // Dataset::ForEachChunk, so a MappedDataset larger than memory trains with only the chunks in use resident and
+  // ends up as the same rows in memory would. Throws TrainingException if the dataset does not have n_input features
+  // and n_output labels.
+  float Train(const Dataset& dataset, int learning_algo, int n_threads = 1, Checkpointer *checkpointer = NULL);
+  // Restores the network and its training to the checkpoint in the file at path, written while training a network of
+  // the same topology and activation: the weights, the optimizer's learning state, the epoch, the normalization
+  // bounds and how the network was being trained. Returns false, leaving the network untouched, if the file cannot
+  // be read or is for another network.
+  bool LoadCheckpoint(const char *path);
+  // Carries on the training last run or restored by LoadCheckpoint until it converges or reaches
+  // kNeuralLearningMaxEpoch, with the same learning algorithm and number of threads, and returns the mean squared
+  // error of the last epoch. Given the same training_data as the training it carries on, unnormalized as it was
+  // given to Train, the network ends up bit for bit as if training had never stopped. Throws TrainingException if
+  // there is no training to carry on or batch_size differs from it.
+  float Resume(const float training_data[], int batch_size, Checkpointer *checkpointer = NULL);
+  float Resume(const Dataset& dataset, Checkpointer *checkpointer = NULL);
+  // Computes one row, leaving the activations of every neuron in the network's state for inspection. As it
+  // writes to the network, no other thread may use the network meanwhile, see InferenceSession for that.
+  // inputs: array of approximated functions inputs, left untouched
   // outputs: results of approximated function with supplied inputs
-  void Compute(float inputs[], float* outputs);
-  // Returns pretty formatted string JSON representation of the neural network in present state.
+  void Compute(const float inputs[], float* outputs);
+  // Computes many rows at once, running each layer as a blocked matrix-matrix product over a tile of rows. Only
+  // reads the network, so any number of threads may call it at once while nothing is training the network.
+  // inputs: n_rows rows of approximated function inputs, each starting input_stride floats after the last or
+  //   n_input floats when input_stride is 0. inputs are left untouched.
+  // outputs: n_rows rows of results, each starting output_stride floats after the last or n_output floats when
+  //   output_stride is 0.
+  void ComputeBatch(const float* inputs, size_t n_rows, float* outputs, size_t input_stride = 0, size_t output_stride = 0) const;
+  // Same as above on the features of dataset, which must be n_input wide, widened to float as they are read.
+  void ComputeBatch(const Dataset& dataset, float* outputs, size_t output_stride = 0) const;
+  // Returns pretty formatted string JSON representation of the neural network in present state, valid until the
+  // network is next asked for JSON or destroyed.
   const char * ToPrettyJSON() {
-    rapidjson::StringBuffer *buffer = new rapidjson::StringBuffer();
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(*buffer);
+    json_buffer_.Clear();
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(json_buffer_);
     this->ToJSON(writer);
-    return buffer->GetString();
+    return json_buffer_.GetString();
   }
-  // Returns string JSON representation of the neural network in present state.
+  // Returns string JSON representation of the neural network in present state, valid until the network is next
+  // asked for JSON or destroyed.
   const char * ToJSON() {
-    rapidjson::StringBuffer *buffer = new rapidjson::StringBuffer();
-    rapidjson::Writer<rapidjson::StringBuffer> writer(*buffer);
+    json_buffer_.Clear();
+    rapidjson::Writer<rapidjson::StringBuffer> writer(json_buffer_);
     this->ToJSON(writer);
-    return buffer->GetString();
+    return json_buffer_.GetString();
   }
+  // Streams the JSON representation of the neural network to the file descriptor fd, which is left open, through a
+  // buffer of kJSONWriteBufferSize bytes the network keeps for its next export. Returns false if it could not be
+  // written.
+  // schema: one of JSONSchemas, both are read back by FromJSON.
+  // pretty: indent the JSON for reading rather than writing it as compactly as possible.
+  bool WriteJSON(int fd, int schema = kJSONSchemaNeurons, bool pretty = false);
   // Streams to rapidjson writer, the JSON representation of the neural network in present state.
   template <typename Writer>
   void ToJSON(Writer& writer) const {
     writer.StartObject();
+    writer.String(("activation"));
+    writer.Int(activation_->id());
+    writer.String(("epoch"));
+    writer.Int(epoch_);
+    writer.String(("maxFloatTraining"));
+    writer.Double(max_float_training_);
+    writer.String(("minFloatTraining"));
+    writer.Double(min_float_training_);
+    NormalizationToJSON(writer);
     writer.String(("inputNeurons"));
     writer.StartArray();
     for (std::vector<Neuron*>::const_iterator neuronItr = input_neurons_.begin(); neuronItr != input_neurons_.end(); ++neuronItr)
@@ -122,23 +222,178 @@ class NeuralNet {
     writer.EndArray();
     writer.EndObject();
   }
+  // Streams to rapidjson writer, the compact JSON representation of the neural network: its topology, activation and
+  // input normalization bounds followed by the weights of each layer as one flat array in storage order, row-major
+  // with a row per neuron of the layer, and its biases as another.
+  template <typename Writer>
+  void ToCompactJSON(Writer& writer) const {
+    writer.StartObject();
+    writer.String(("activation"));
+    writer.Int(activation_->id());
+    writer.String(("epoch"));
+    writer.Int(epoch_);
+    writer.String(("maxFloatTraining"));
+    writer.Double(max_float_training_);
+    writer.String(("minFloatTraining"));
+    writer.Double(min_float_training_);
+    NormalizationToJSON(writer);
+    writer.String(("inputCount"));
+    writer.Int(n_input_);
+    writer.String(("hiddenCount"));
+    writer.Int(n_hidden_);
+    writer.String(("outputCount"));
+    writer.Int(n_output_);
+    writer.String(("layers"));
+    writer.StartArray();
+    for (size_t x = 1; x < plan_.size(); x++) {
+      const Layer *layer = plan_[x];
+      int n_weights = layer->n_neurons() * layer->n_inputs();
+      writer.StartObject();
+      writer.String(("name"));
+      writer.String(layer->name());
+      writer.String(("weights"));
+      writer.StartArray();
+      for (int i = 0; i < n_weights; i++) writer.Double(layer->params()[i]);
+      writer.EndArray();
+      writer.String(("biases"));
+      writer.StartArray();
+      for (int i = n_weights; i < layer->n_params(); i++) writer.Double(layer->params()[i]);
+      writer.EndArray();
+      writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+  }
   // this is the number of training iterations that were required to converge
   int epoch() const { return epoch_; }
+  // One of Normalizations, the way the next Train normalizes the inputs, kNormalizationRange by default. The
+  // normalization found is kept with the network and goes wherever it is saved.
+  int normalization() const { return normalization_; }
+  void set_normalization(int normalization) { normalization_ = normalization; }
+  // Input x of a row enters the network as inputs[x] * input_scale()[x] + input_offset()[x], n_input values each.
+  // They leave inputs as they are until the network is trained.
+  const float* input_scale() const { return input_scale_; }
+  const float* input_offset() const { return input_offset_; }
+  // Number of layers, the input layer included. Layer 0 is the input layer, which has no parameters, layer 1 the
+  // hidden layer and layer n_layers() - 1 the output layer.
+  int n_layers() const { return plan_.size(); }
+  // Number of weights and biases feeding layer idx.
+  int n_params(int idx) const { return plan_.at(idx)->n_params(); }
+  // Views of the weights and biases feeding layer idx, read in place with no copy, see Layer::params_view_t. They
+  // follow training and SetParams and are valid until the network is destroyed. Throws std::out_of_range for an idx
+  // that is not a layer.
+  Layer::params_view_t weights(int idx) const { return plan_.at(idx)->weights_view(); }
+  Layer::params_view_t biases(int idx) const { return plan_.at(idx)->biases_view(); }
+  // Copies the weights and biases feeding layer idx from params, n_params(idx) values laid out as the views lay them
+  // out: the weights row-major then the biases. Returns false, leaving the layer untouched, if idx is not a layer with
+  // parameters or count is not n_params(idx). No other thread may use the network meanwhile.
+  bool SetParams(int idx, const float *params, size_t count);
 
 private:
-  void BuildNetwork(float (*activation)(float), float (*activation_p)(float), float *start_weights);
-  void NormalizeInputs(float* training_data, int batch_size);
+  friend class FrozenNet;
+  friend class InferenceSession;
+  friend class JSONModelReader;
+  // ComputeBatch with the activations of each layer for a tile of rows kept in tiles, which is grown as needed.
+  void ComputeBatch(const Dataset& dataset, float* outputs, size_t output_stride,
+                    std::vector< std::vector<float> >* tiles) const;
+  // Describes training_data as Train has always taken it, batch_size rows of n_input inputs then n_output ideal
+  // outputs, or rows of inputs alone input_stride floats apart.
+  Dataset PackedDataset(const float* training_data, int batch_size) const;
+  Dataset InputsDataset(const float* inputs, size_t n_rows, size_t input_stride) const;
+  // Builds the network header describes on the parameters of the model file mapped at mapping, whose header has
+  // been checked, or with zeroed parameters for a reader to fill in when mapping is NULL.
+  NeuralNet (const model_file_header_t &header, void *mapping, size_t mapping_size, Activation *activation);
+  // Builds the layers and neurons. The layers' parameters are start_weights when given, hidden_params and
+  // output_params when those are given, and zero otherwise. The input scales and offsets are the n_input floats each
+  // at normalization when given and leave the inputs as they are otherwise.
+  void BuildNetwork(float *start_weights, float *hidden_params = NULL, float *output_params = NULL,
+                    float *normalization = NULL);
+  template <typename Writer>
+  void ToJSON(Writer& writer, int schema) const {
+    if (schema == kJSONSchemaCompact) ToCompactJSON(writer);
+    else ToJSON(writer);
+  }
+  template <typename Writer>
+  void NormalizationToJSON(Writer& writer) const {
+    writer.String(("normalization"));
+    writer.Int(normalization_);
+    writer.String(("inputScale"));
+    writer.StartArray();
+    for (int x = 0; x < n_input_; x++) writer.Double(input_scale_[x]);
+    writer.EndArray();
+    writer.String(("inputOffset"));
+    writer.StartArray();
+    for (int x = 0; x < n_input_; x++) writer.Double(input_offset_[x]);
+    writer.EndArray();
+  }
+  // Creates the optimizer Train applies gradients with and gives layers built on borrowed parameters gradient sums.
+  void InitLearningState();
+  void CompilePlan();
+  void Forward();
+  // Runs epochs of the training in training_ over the normalized training_data until it converges or reaches
+  // kNeuralLearningMaxEpoch.
+  float TrainEpochs(const Dataset& dataset, Checkpointer *checkpointer);
+  // Copies the state of the training into a buffer of checkpointer and hands it over to be written.
+  void TakeCheckpoint(Checkpointer *checkpointer) const;
+  float TrainRows(const Dataset& dataset, long begin, long end, Layer::workspace_t** workspaces, float mse);
+  // Sets the input scales and offsets, and the bounds of all the inputs, from the features of dataset in one pass of
+  // the column_stats kernel shared by n_threads threads.
+  void ComputeNormalization(const Dataset& dataset, int n_threads);
+  // Sets the input scales and offsets to map every input from [min_float_training_, max_float_training_].
+  void SetRangeNormalization();
+  void NormalizeRow(const float* inputs, float* normalized) const;
+  // Normalizes the features of row of dataset, widening them into normalized first unless they are floats.
+  void NormalizeRow(const Dataset& dataset, long row, float* normalized) const;
   std::vector<Neuron*> input_neurons_;
   std::vector<Neuron*> bias_neurons_;
   std::vector<Neuron*> hidden_neurons_;
   std::vector<Neuron*> output_neurons_;
   std::vector<Neuron*> neurons_;
+  // Layers in forward order, the backward schedule is the same layers walked in reverse.
+  std::vector<Layer*> plan_;
+  Layer *input_layer_;
+  Layer *hidden_layer_;
+  Layer *output_layer_;
+  Activation *activation_;
+  Arena *arena_;
+  // Learning state of the network, created by its first Train.
+  Optimizer *optimizer_;
+  // Gradient sums of a network built on a mapped model file, allocated by its first Train.
+  Arena *learning_arena_;
+  // The mapped model file, if any, and its size.
+  void *mapping_;
+  size_t mapping_size_;
   int n_input_;
   int n_hidden_;
   int n_output_;
   int epoch_;
+  // How the network was last trained, for Resume and checkpoints, see model_checkpoint_header_t. batch_size is 0
+  // until the network is first trained.
+  struct {
+    int learning_algo;
+    int n_threads;
+    int batch_size;
+    float mse;
+  } training_;
   float max_float_training_;
   float min_float_training_;
+  int normalization_;
+  // n_input floats each, in the arena or in the mapped model file.
+  float *input_scale_;
+  float *input_offset_;
+  // Hold the string ToJSON and ToPrettyJSON return and the buffer WriteJSON streams through between exports.
+  rapidjson::StringBuffer json_buffer_;
+  std::vector<char> write_buffer_;
+};
+
+// NeuralNet with its activation chosen at compile time from an activation policy such as Sigmoid, TanhScaled or
+// ReLU, so that the activation and derivative loops over each layer are compiled for it rather than calling
+// through a function pointer per neuron.
+template <class Policy>
+class BasicNeuralNet : public NeuralNet {
+ public:
+  BasicNeuralNet (int n_input, int n_hidden, int n_output, float *start_weights = NULL)
+      : NeuralNet(n_input, n_hidden, n_output, new PolicyActivation<Policy>(), start_weights) { }
 };
 
 } //namespace neuralplex
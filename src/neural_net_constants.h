@@ -40,6 +40,34 @@ enum LearningAlgorithms {
   kLearningAlgorithmsResilientProp
 };
 
+// Layouts of the JSON representation of a network. kJSONSchemaNeurons lists every neuron with its activations and
+// the synapses to its parents and children. kJSONSchemaCompact lists each layer's weights and biases as flat arrays
+// in storage order, which is all a network needs to be read back.
+enum JSONSchemas {
+  kJSONSchemaNeurons = 0,
+  kJSONSchemaCompact
+};
+
+// How Train maps each input before it enters the network. kNormalizationRange maps every input linearly from the
+// range of all the training inputs onto [kNeuralInputLower, kNeuralInputUpper], as the network always has.
+// kNormalizationFeatureRange does the same with each input's own range, and kNormalizationFeatureStandard maps each
+// input to zero mean and unit standard deviation over the training rows. An input that never varies keeps a scale of
+// 1 and is only shifted, onto kNeuralInputLower or to zero mean, so it lands in range and a value training never saw
+// still reaches the network.
+enum Normalizations {
+  kNormalizationRange = 0,
+  kNormalizationFeatureRange,
+  kNormalizationFeatureStandard
+};
+
+// Types a column of a Dataset can be stored in, see Dataset. kColumnFloat16 is IEEE binary16.
+enum ColumnTypes {
+  kColumnUint8 = 0,
+  kColumnInt16,
+  kColumnFloat16,
+  kColumnFloat32
+};
+
 //const unsigned int kMaxBatchSize = 20;
 const float kNeuralInputUpper = 1.0f;
 const float kNeuralInputLower = -1.0f;
@@ -53,6 +81,20 @@ const float kResilientPropDeltaMax = 50.0;
 const float kResilientPropUpdateMin = 1e-6;
 const float kResilientPropSlower = 0.5;
 const float kResilientPropFaster = 1.2;
+// Rows ComputeBatch pushes through each layer at a time, sized so one tile of activations stays in L2.
+const int kComputeBatchRows = 64;
+// Rows each training worker pushes forwards and backwards at a time, so that each layer's gradients are one matrix
+// product per tile rather than one outer product per row.
+const int kTrainBatchRows = 64;
+// Bytes of a dataset each worker reads at a time, see Dataset::ForEachChunk. A mapped dataset keeps about two chunks
+// per worker resident however large it is.
+const long kDatasetChunkBytes = 64L << 20;
+// Parameters drawn from each random stream when weights are initialised, the unit of work shared between threads.
+const int kInitBlockParams = 16384;
+// Bytes FromJSON reads from the file at a time.
+const int kJSONReadBufferSize = 65536;
+// Bytes WriteJSON buffers before each write to the file.
+const int kJSONWriteBufferSize = 65536;
 
 } //namespace neuralplex
 #endif /*NEURAL_NET_CONSTANTS_H_*/
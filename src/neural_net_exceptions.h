@@ -29,6 +29,7 @@
 #define NEURAL_NET_EXCEPTIONS_H_
 
 #include <stdexcept>
+#include <string>
 
 namespace neuralplex {
 
@@ -37,5 +38,25 @@ class UndefinedLearningAlgoException: public std::runtime_error {
   UndefinedLearningAlgoException() : std::runtime_error("UndefinedLearningAlgoException: No supported learning algorithim was specified.") { }
 };
 
+class ModelFileException: public std::runtime_error {
+ public:
+  explicit ModelFileException(const std::string& reason) : std::runtime_error("ModelFileException: " + reason) { }
+};
+
+class TrainingException: public std::runtime_error {
+ public:
+  explicit TrainingException(const std::string& reason) : std::runtime_error("TrainingException: " + reason) { }
+};
+
+class DatasetException: public std::runtime_error {
+ public:
+  explicit DatasetException(const std::string& reason) : std::runtime_error("DatasetException: " + reason) { }
+};
+
+class ParamsException: public std::runtime_error {
+ public:
+  explicit ParamsException(const std::string& reason) : std::runtime_error("ParamsException: " + reason) { }
+};
+
 } //namespace neuralplex
 #endif /*NEURAL_NET_EXCEPTIONS_H_*/
@@ -31,12 +31,15 @@
 #include<stdlib.h>
 #include<string>
 #include<vector>
+#include "layer.h"
 #include "rapidjson/filestream.h"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/stringbuffer.h"
 
 namespace neuralplex {
 
+class Optimizer;
+
 // The neural network will start by neurons sorted input to output, Forward method is ran on each neuron,
 // in a forward feeding manner to calculate the output values based on summing the parent neurons
 // output multiplied by the weight between child and parent. We can then compare the ideal provided in
@@ -48,114 +51,107 @@ namespace neuralplex {
 // neuron, and a second bias neuron connected to each output neuron is used to allow the network to arrive at
 // outputs greater or smaller than the range if the provided activation function providing more signal coverage
 // and likelihood to converge.
+// A Neuron does not own any weights or state of its own, it is a handle onto neuron idx of a Layer which keeps
+// the weights feeding it. A bias neuron is a handle onto the bias vector of the layer it feeds.
 class Neuron {
  public:
-  typedef struct {
-    Neuron* parent;
-    Neuron* child;
-    float weight;
-    float last_delta;
-    float last_gradient_batch_sum;
-    float update_val;
-    float last_update_val;
-    float next_weight;
-    float weight_delta;
-    float last_weight_delta;
-    std::vector <float> batch_gradients;
-  } synapse_t;
+  static const int kBiasIdx = -1;
 
-  Neuron(std::string name, float (*activation)(float), float (*activation_prime)(float));
-  virtual ~Neuron();
-  void ConnectTo(Neuron *n, float weight);
+  //Neuron(): construct a new Neuron
+  // layer: the layer the neuron belongs to, or for a bias neuron the layer it feeds.
+  // idx: position of the neuron within layer, or kBiasIdx for a bias neuron.
+  Neuron(Layer *layer, int idx);
   void Forward();
   void Backward();
-  void Learn(int learning_algo);
-  float input() const { return input_; }
-  void set_input(float input) { has_input_ = true; input_ = input; }
-  float ideal() const { return ideal_; }
-  void set_ideal(float ideal) { has_ideal_ = true; ideal_ = ideal; }
-  std::string name() const { return name_; }
-  float output() const { return output_; }
-  float error() const { return error_; }
-  float delta() const { return delta_; }
+  // Applies the summed batch gradients of the weights feeding the neuron with the learning state of optimizer.
+  void Learn(Optimizer *optimizer, int learning_algo);
+  float input() const { return is_bias() ? 1.0f : layer_->summation(idx_); }
+  void set_input(float input) { layer_->set_input(idx_, input); }
+  float ideal() const { return is_bias() ? 0.0f : layer_->ideal(idx_); }
+  void set_ideal(float ideal) { layer_->set_ideal(idx_, ideal); }
+  std::string name() const { return is_bias() ? layer_->bias_name() : layer_->neuron_name(idx_); }
+  float output() const { return is_bias() ? 1.0f : layer_->output(idx_); }
+  float summation() const { return is_bias() ? 1.0f : layer_->summation(idx_); }
+  float error() const { return is_bias() ? 0.0f : layer_->error(idx_); }
+  float delta() const { return is_bias() ? 0.0f : layer_->delta(idx_); }
   int layer_idx() const { return layer_idx_; }
   void set_layer_idx(int layer_idx) { layer_idx_ = layer_idx; }
-  std::vector <synapse_t>& parents()  { return parents_; }
-  std::vector <synapse_t>& children()  { return children_; }
-  // Returns pretty formatted string JSON representation of the neuron in present state.
+  bool is_bias() const { return idx_ == kBiasIdx; }
+  Layer* layer() const { return layer_; }
+  int idx() const { return idx_; }
+  // Returns pretty formatted string JSON representation of the neuron in present state, valid until the calling
+  // thread next asks a neuron for JSON.
   const char * ToPrettyJSON() {
-    rapidjson::StringBuffer *buffer = new rapidjson::StringBuffer();
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(*buffer);
+    rapidjson::StringBuffer &buffer = JSONBuffer();
+    buffer.Clear();
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
     this->ToJSON(writer);
-    return buffer->GetString();
+    return buffer.GetString();
   }
-  // Returns string JSON representation of the neuron in present state.
+  // Returns string JSON representation of the neuron in present state, valid until the calling thread next asks a
+  // neuron for JSON.
   const char * ToJSON() {
-    rapidjson::StringBuffer *buffer = new rapidjson::StringBuffer();
-    rapidjson::Writer<rapidjson::StringBuffer> writer(*buffer);
+    rapidjson::StringBuffer &buffer = JSONBuffer();
+    buffer.Clear();
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
     this->ToJSON(writer);
-    return buffer->GetString();
+    return buffer.GetString();
   }
   // Streams to rapidjson writer, the JSON representation of the neuron in present state.
   template <typename Writer>
   void ToJSON(Writer& writer) const {
     writer.StartObject();
     writer.String(("name"));
-    writer.String(name_);
+    writer.String(name());
     writer.String("output");
-    writer.Double(output_);
+    writer.Double(output());
     writer.String("summation");
-    writer.Double(summation_);
+    writer.Double(summation());
     writer.String("error");
-    writer.Double(error_);
+    writer.Double(error());
     writer.String("delta");
-    writer.Double(delta_);
+    writer.Double(delta());
     writer.String("layer");
     writer.Int(layer_idx_);
     writer.String(("parents"));
     writer.StartArray();
-    for (std::vector<synapse_t>::const_iterator synapseItr = parents_.begin(); synapseItr != parents_.end(); ++synapseItr) {
-      writer.StartObject();
-      writer.String(("weight"));
-      writer.Double(synapseItr->weight);
-      writer.String(("neuron"));
-      writer.String(synapseItr->parent->name());
-      writer.EndObject();
+    if (!is_bias() && layer_->below()) {
+      WriteSynapse(writer, layer_->bias(idx_), layer_->bias_name());
+      for (int x = 0; x < layer_->n_inputs(); x++) WriteSynapse(writer, layer_->weight(idx_, x), layer_->below()->neuron_name(x));
     }
     writer.EndArray();
     writer.String(("children"));
     writer.StartArray();
-    for (std::vector<synapse_t>::const_iterator synapseItr = children_.begin(); synapseItr != children_.end(); ++synapseItr) {
-      writer.StartObject();
-      writer.String(("weight"));
-      writer.Double(synapseItr->weight);
-      writer.String(("neuron"));
-      writer.String(synapseItr->child->name());
-      writer.EndObject();
+    if (is_bias()) {
+      for (int x = 0; x < layer_->n_neurons(); x++) WriteSynapse(writer, layer_->bias(x), layer_->neuron_name(x));
+    } else if (layer_->above()) {
+      Layer *above = layer_->above();
+      for (int x = 0; x < above->n_neurons(); x++) WriteSynapse(writer, above->weight(x, idx_), above->neuron_name(x));
     }
     writer.EndArray();
     writer.EndObject();
   }
   
  private:
-  void LearnBackProp();
-  void LearnRProp();
-  bool has_input_;
-  bool has_ideal_;
-  float summation_;
-  float ideal_;
-  float input_;
-  std::string name_;
-  float (*activation_)(float);
-  float (*activation_prime_)(float);
-  float output_;
-  float error_;
-  float delta_;
+  // Buffer the string representations are written to, one per thread and reused, as neurons live in their network's
+  // arena and hold nothing that needs freeing.
+  static rapidjson::StringBuffer& JSONBuffer() {
+    static thread_local rapidjson::StringBuffer buffer;
+    return buffer;
+  }
+  template <typename Writer>
+  static void WriteSynapse(Writer& writer, float weight, const std::string& neuron) {
+    writer.StartObject();
+    writer.String(("weight"));
+    writer.Double(weight);
+    writer.String(("neuron"));
+    writer.String(neuron);
+    writer.EndObject();
+  }
+  Layer *layer_;
+  int idx_;
   int layer_idx_;
-  std::vector <synapse_t> children_;
-  std::vector <synapse_t> parents_;
 };
 
 }  //namespace neuralplex
 #endif /*NEURON_H_*/
-
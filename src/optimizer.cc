@@ -0,0 +1,108 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "neural_net_constants.h"
+#include "neural_net_exceptions.h"
+#include "optimizer.h"
+
+namespace neuralplex {
+
+Optimizer::Optimizer(const std::vector<Layer*>& layers) : arena_(ArenaSize(layers)), states_(layers.size()) {
+  kernels_ = &Kernels();
+  for (size_t x = 0; x < layers.size(); x++) {
+    int n_params = layers[x]->n_params();
+    learning_state_t &state = states_[layers[x]->idx()];
+    state = learning_state_t();
+    if (n_params == 0) continue;
+    state.last_delta = arena_.AllocateFloats(n_params);
+    state.last_gradient_batch_sum = arena_.AllocateFloats(n_params);
+    state.update_val = arena_.AllocateFloats(n_params, kResilientPropInitUpdateVal);
+    state.last_update_val = arena_.AllocateFloats(n_params, kResilientPropInitUpdateVal);
+    state.next_step = arena_.AllocateFloats(n_params);
+    state.weight_delta = arena_.AllocateFloats(n_params);
+    state.last_weight_delta = arena_.AllocateFloats(n_params);
+  }
+}
+
+Optimizer::~Optimizer() {}
+
+// Seven learning state fields per parameter of every layer.
+size_t Optimizer::ArenaSize(const std::vector<Layer*>& layers) {
+  size_t size = 0;
+  for (size_t x = 0; x < layers.size(); x++) size += 7 * Arena::Aligned(layers[x]->n_params() * sizeof(float));
+  return size;
+}
+
+void Optimizer::Learn(Layer *layer, int learning_algo) {
+  LearnParams(layer, 0, layer->n_params(), learning_algo);
+}
+
+void Optimizer::Learn(Layer *layer, int n, int learning_algo) {
+  // The input layer has no parameters, the call is still made so that an unknown algorithm is reported.
+  int n_inputs = layer->n_inputs();
+  LearnParams(layer, n * n_inputs, n_inputs, learning_algo);
+  if (n_inputs) LearnParams(layer, layer->n_neurons() * n_inputs + n, 1, learning_algo);
+}
+
+void Optimizer::LearnParams(Layer *layer, int begin, int count, int learning_algo) {
+  switch (learning_algo) {
+    case kLearningAlgorithmsBackProp:
+      LearnBackProp(layer, begin, count);
+      break;
+    case kLearningAlgorithmsResilientProp:
+      LearnRProp(layer, begin, count);
+      break;
+    default:
+      throw UndefinedLearningAlgoException();
+  }
+}
+
+void Optimizer::LearnBackProp(Layer *layer, int begin, int count) {
+  float *weight = layer->mutable_params() + begin;
+  float *gradient = layer->workspace()->gradients + begin;
+  float *last_delta = states_[layer->idx()].last_delta + begin;
+  for (int x = 0; x < count; x++) {
+    float gradient_batch_sum = gradient[x];
+    gradient[x] = 0.0f;
+    last_delta[x] = ((kBackPropLearningRate * gradient_batch_sum) + (kBackPropMomentum * last_delta[x]));
+    weight[x] += last_delta[x];
+  }
+}
+
+void Optimizer::LearnRProp(Layer *layer, int begin, int count) {
+  const learning_state_t &learning_state = states_[layer->idx()];
+  rprop_state_t state;
+  state.last_gradient_batch_sum = learning_state.last_gradient_batch_sum + begin;
+  state.update_val = learning_state.update_val + begin;
+  state.last_update_val = learning_state.last_update_val + begin;
+  state.next_step = learning_state.next_step + begin;
+  state.weight_delta = learning_state.weight_delta + begin;
+  state.last_weight_delta = learning_state.last_weight_delta + begin;
+  kernels_->rprop(layer->mutable_params() + begin, layer->workspace()->gradients + begin, state, count);
+}
+
+}  //namespace neuralplex
@@ -0,0 +1,82 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef OPTIMIZER_H_
+#define OPTIMIZER_H_
+
+#include<stdlib.h>
+#include<vector>
+#include "arena.h"
+#include "kernels.h"
+#include "layer.h"
+
+namespace neuralplex {
+
+// Optimizer keeps the learning state of every weight and bias of a network's layers and applies the summed batch
+// gradients of a layer to the layer's parameters. The state lives in arrays of the optimizer's own, in the same
+// parameter order as the layer, so a layer holds nothing but its parameters and activations and computing rows
+// never pulls learning state through the cache. A network only creates its optimizer once it trains.
+class Optimizer {
+ public:
+  // Learning state kept for every parameter by the back and resilient propagation learning rules, each field an
+  // array in parameter order so that the rules sweep whole arrays rather than one weight at a time.
+  typedef struct {
+    float *last_delta;
+    float *last_gradient_batch_sum;
+    float *update_val;
+    float *last_update_val;
+    float *next_step;
+    float *weight_delta;
+    float *last_weight_delta;
+  } learning_state_t;
+
+  //Optimizer(): construct a new Optimizer
+  // layers: the layers of the network indexed by Layer::idx(), which must outlive the optimizer.
+  explicit Optimizer(const std::vector<Layer*>& layers);
+  virtual ~Optimizer();
+  // Applies the summed batch gradients to every weight and bias in layer and clears the sums.
+  void Learn(Layer *layer, int learning_algo);
+  // Applies the summed batch gradients to the weights and bias feeding neuron n of layer and clears the sums.
+  void Learn(Layer *layer, int n, int learning_algo);
+  // Learning state of the parameters of layer, every field NULL for a layer without parameters.
+  const learning_state_t& state(const Layer *layer) const { return states_[layer->idx()]; }
+
+ private:
+  Optimizer(const Optimizer&);
+  Optimizer& operator=(const Optimizer&);
+  static size_t ArenaSize(const std::vector<Layer*>& layers);
+  // Applies the summed batch gradients of the count parameters of layer from begin and clears the sums.
+  void LearnParams(Layer *layer, int begin, int count, int learning_algo);
+  void LearnBackProp(Layer *layer, int begin, int count);
+  void LearnRProp(Layer *layer, int begin, int count);
+  Arena arena_;
+  std::vector<learning_state_t> states_;
+  const kernels_t *kernels_;
+};
+
+}  //namespace neuralplex
+#endif /*OPTIMIZER_H_*/
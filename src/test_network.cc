@@ -36,22 +36,6 @@
 #include "rapidjson/filestream.h"
 #include "rapidjson/prettywriter.h"
 
-float TanhScaled(float x){
-  return 1.7159*tanh(0.66666667*x);
-}
-
-float TanhScaledPrime(float x) {
-  return 0.66666667/1.7159*(1.7159+tanh(x))*(1.7159-tanh(x));
-}
-
-float Sigmoid(float x) {
-  return 1/(1+pow(exp(1.0), -x));
-}
-
-float SigmoidPrime(float x) {
-  return Sigmoid(x) * (1.0-Sigmoid(x));
-}
-
 int main () {
   MYSQL *conn;
   MYSQL_RES *res_good;
@@ -125,34 +109,38 @@ int main () {
   unsigned int n_good_rows = mysql_num_rows(res_good);
   unsigned int n_bad_rows = mysql_num_rows(res_bad);
   unsigned int batch_size = n_good_rows+n_bad_rows;
-  float training_data_arr[n_good_rows+n_bad_rows][n_fields*n_field_max_length+1];
+  unsigned int n_input = n_fields*n_field_max_length;
+  // Each row is a record of one byte per character followed by a one byte label, a quarter of the size the same row
+  // takes as floats. The dataset reads the characters as the features and the last byte as the label.
+  unsigned int n_record = n_input + 1;
+  std::vector<uint8_t> training_data(batch_size * n_record, 0);
   unsigned int k = 0;
   while ((row = mysql_fetch_row(res_good)) != NULL) {
     for (unsigned int j = 0; j < n_fields; j++) {
       for (unsigned int i = 0; i < n_field_max_length; i++) {
-        float c = 0;
-        if (row[j] && i < strlen(row[j])) c = (float)row[j][i];
-        training_data_arr[k][j*n_field_max_length+i] = c;
+        uint8_t c = 0;
+        if (row[j] && i < strlen(row[j])) c = (uint8_t)row[j][i];
+        training_data[k*n_record+j*n_field_max_length+i] = c;
       }
     }
-    training_data_arr[k][n_field_max_length*n_fields] = 1.0f;
-   // training_data_arr[k][n_field_max_length*n_fields+1] = -1.0f;
+    training_data[k*n_record+n_input] = 1;
     k++;
   }
   while ((row = mysql_fetch_row(res_bad)) != NULL) {
     for (unsigned int j = 0; j < n_fields; j++) {
       for (unsigned int i = 0; i < n_field_max_length; i++) {
         //std::cout << "FF: char: " << row[j][i]  << std::endl;
-        int c = 0;
-        if (row[j] && i < strlen(row[j])) c = (int)row[j][i];
-        training_data_arr[k][j*n_field_max_length+i] = c;
-        //std::cout << "FF: char: " << row[j][i] << " int: " << (int)row[j][i] << " float1: " << (float)(int)row[j][i] << " float2: " << training_data_arr[k][j*n_field_max_length+i] << std::endl;
+        uint8_t c = 0;
+        if (row[j] && i < strlen(row[j])) c = (uint8_t)row[j][i];
+        training_data[k*n_record+j*n_field_max_length+i] = c;
       }
     }
-    training_data_arr[k][n_field_max_length*n_fields] = 0.0f;
-  //  training_data_arr[k][n_field_max_length*n_fields+1] = 1.0f;
+    training_data[k*n_record+n_input] = 0;
     k++;
   }
+  neuralplex::Dataset training_set(
+      batch_size, neuralplex::Dataset::Columns(&training_data[0], neuralplex::kColumnUint8, n_input, n_record),
+      neuralplex::Dataset::Columns(&training_data[n_input], neuralplex::kColumnUint8, n_output, n_record));
   mysql_free_result(res_good);
   mysql_free_result(res_bad);
   if (mysql_query(conn, all_user_query.c_str())) {
@@ -165,26 +153,17 @@ int main () {
   std::vector<std::string> emails;
   std::vector<std::string> statuses;
 
-  std::vector < std::vector<float> > test_data_arr;
-  //test_data_arr = (float*) malloc(n_all_rows * n_fields * n_field_max_length * sizeof(float));
-
-  for (unsigned int i = 0; i < n_all_rows; i++) {
-    std::vector<float> init_data;
-    for (unsigned int j = 0; j < (n_fields*n_field_max_length); j++) {
-      init_data.push_back(0.0f);
-    }
-    test_data_arr.push_back(init_data);
-  }
+  // Rows are packed one after another, a byte per character, so they can be scored in a single ComputeBatch call.
+  std::vector<uint8_t> test_data(n_all_rows * n_input, 0);
   k = 0;
 
   while ((row = mysql_fetch_row(res_all)) != NULL) {
     for (unsigned int j = 0; j < n_fields; j++) {
       for (unsigned int i = 0; i < n_field_max_length; i++) {
-        float c = 0;
+        uint8_t c = 0;
 
-        if (row[j] && i < strlen(row[j])) c = (float)(int)row[j][i];
-        test_data_arr[k][j*n_field_max_length+i] = c;
-     // std::cout << "strlen(row[j]): " << strlen(row[j]) << " i: " << i <<  "FF: char: " << c << " int: " << (int)row[j][i] << " float1: " << (float)(int)row[j][i] << " float2: " << test_data_arr[k][j*n_field_max_length+i] << std::endl;
+        if (row[j] && i < strlen(row[j])) c = (uint8_t)row[j][i];
+        test_data[k*n_input+j*n_field_max_length+i] = c;
       }
     }
     user_ids.push_back(row[n_fields]);
@@ -194,16 +173,15 @@ int main () {
   }
 
   mysql_free_result(res_all);
-  //std::random_shuffle(training_data_arr[0], training_data_arr[batch_size-1]);
-  //for (int i = 0; i < batch_size; i++) { for (int j = 0; j < n_fields*n_field_max_length+1; j++) { std::cout << training_data_arr[i][j] << ","; }; std::cout << std::endl;  }
-  unsigned int n_input = n_fields*n_field_max_length;
   bool did_converge = false;
   long long elapsed_time  = 0;
   struct timeval start, end;
   gettimeofday(&start, NULL);
   std::cout << std::endl << "STARTING: " << std::endl;
-  neuralplex::NeuralNet *neural_net = new neuralplex::NeuralNet(n_input, n_hidden, n_output, Sigmoid, SigmoidPrime);
-  float global_error = neural_net->Train(*training_data_arr, batch_size, neuralplex::kLearningAlgorithmsResilientProp);
+  neuralplex::NeuralNet *neural_net = new neuralplex::BasicNeuralNet<neuralplex::FastSigmoid>(n_input, n_hidden, n_output);
+  // Each character position spans its own range of codes.
+  neural_net->set_normalization(neuralplex::kNormalizationFeatureRange);
+  float global_error = neural_net->Train(training_set, neuralplex::kLearningAlgorithmsResilientProp);
   if (global_error <= neuralplex::kNeuralLearningThreshold) {
     did_converge = true;
     gettimeofday(&end, NULL);
@@ -215,15 +193,14 @@ int main () {
     std::cout << "GENERATED NETWORK:" << std::endl;
     std::cout << neural_net->ToJSON() << std::endl << std::endl;
     std::cout << std::endl << "TEST RESULTS:" << std::endl;
-    for(int i = 0; i < n_all_rows; i++) {
-      float results[n_output];
-      /*for(int j = 0; j < n_output; j++) {
-        results[i] = 0.0f;
-      }*/
-      neural_net->Compute(&test_data_arr[i][0], &results[0]);
+    std::vector<float> results(n_all_rows * n_output);
+    neuralplex::Dataset test_set(n_all_rows,
+                                 neuralplex::Dataset::Columns(&test_data[0], neuralplex::kColumnUint8, n_input));
+    neural_net->ComputeBatch(test_set, &results[0]);
+    for(unsigned int i = 0; i < n_all_rows; i++) {
       std::cout << user_ids[i] << ",\"" <<  statuses[i] << "\",\"" <<  emails[i] << "\",";
-      for(int j = 0; j < n_output; j++) {
-        std::cout  << results[j] << ",";
+      for(unsigned int j = 0; j < n_output; j++) {
+        std::cout  << results[i*n_output+j] << ",";
       }
       std::cout  << std::endl;
     }
@@ -0,0 +1,89 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "worker_pool.h"
+
+namespace neuralplex {
+
+WorkerPool::WorkerPool(int n_workers) {
+  if (n_workers <= 0) n_workers = std::thread::hardware_concurrency();
+  if (n_workers <= 0) n_workers = 1;
+  task_ = NULL;
+  generation_ = 0;
+  n_running_ = 0;
+  stopping_ = false;
+  for (int worker = 1; worker < n_workers; worker++) threads_.push_back(std::thread(&WorkerPool::Work, this, worker));
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_.notify_all();
+  for (std::vector<std::thread>::iterator it = threads_.begin(); it != threads_.end(); ++it) it->join();
+}
+
+void WorkerPool::Run(const std::function<void(int)>& task) {
+  if (threads_.empty()) {
+    task(0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    n_running_ = threads_.size();
+    generation_++;
+  }
+  start_.notify_all();
+  task(0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return n_running_ == 0; });
+  task_ = NULL;
+}
+
+void WorkerPool::Shard(long n, int worker, long *begin, long *end) const {
+  *begin = n * worker / n_workers();
+  *end = n * (worker + 1) / n_workers();
+}
+
+void WorkerPool::Work(int worker) {
+  long generation = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    start_.wait(lock, [this, generation] { return stopping_ || generation_ != generation; });
+    if (stopping_) return;
+    generation = generation_;
+    const std::function<void(int)>* task = task_;
+    lock.unlock();
+    (*task)(worker);
+    lock.lock();
+    if (--n_running_ == 0) done_.notify_one();
+  }
+}
+
+}  //namespace neuralplex
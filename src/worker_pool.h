@@ -0,0 +1,67 @@
+// neuralplex is distributed under BSD license reproduced below.
+//
+// Copyright (c) 2015 Gregory "f3z0" Ray, f3z0@fezo.com
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of the psutil authors nor the names of its contributors
+//    may be used to endorse or promote products derived from this software without
+//    specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace neuralplex {
+
+// WorkerPool keeps n_workers - 1 threads parked between jobs so that a job which is run once per epoch does not pay
+// for creating and joining threads every time. The calling thread works as worker 0.
+class WorkerPool {
+ public:
+  //WorkerPool(): construct a new WorkerPool
+  // n_workers: number of workers including the calling thread, 0 for one per hardware thread.
+  explicit WorkerPool(int n_workers);
+  virtual ~WorkerPool();
+  // Runs task(worker) once for every worker in [0, n_workers) and returns once all of them have finished.
+  // task must not throw.
+  void Run(const std::function<void(int)>& task);
+  int n_workers() const { return threads_.size() + 1; }
+  // Splits n items into n_workers contiguous shards, sets [begin, end) to the shard of worker.
+  void Shard(long n, int worker, long *begin, long *end) const;
+
+ private:
+  void Work(int worker);
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const std::function<void(int)>* task_;
+  long generation_;
+  int n_running_;
+  bool stopping_;
+};
+
+}  //namespace neuralplex
+#endif /*WORKER_POOL_H_*/